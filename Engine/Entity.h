@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <string>
+#include <memory>
 #include <glm/mat4x4.hpp>
 #include "BoundingBox.h"
 #include <glm/detail/_vectorize.hpp>
@@ -9,6 +10,9 @@ namespace pilot
 
 	class Terrain;
 	class Entity;
+	class FlowField;
+	class IncrementalPathPlanner;
+	class PathTicket;
 
 	/**
 	 * \brief This contains all the data required for the actual Gameplay.
@@ -30,6 +34,11 @@ namespace pilot
 		*/
 		bool attackingMode = false;
 
+		/**
+		 * \brief Set when the Player gives an Order, till we have asked for a Path for it.
+		 */
+		bool newOrder = false;
+
 		/**
 		* \brief Being Attacked By Someone
 		*/
@@ -87,6 +96,21 @@ namespace pilot
 		 */
 		glm::ivec2 targetNode{};
 
+		/**
+		 * \brief The Flow Field to follow, for a Group Move Order. nullptr when we find our own Path to the Target Node.
+		 */
+		std::shared_ptr<FlowField> flowField;
+
+		/**
+		 * \brief Keeps the last Search to the Target Node around, so that it only has to be repaired when Obstacles are placed.
+		 */
+		std::shared_ptr<IncrementalPathPlanner> pathPlanner;
+
+		/**
+		 * \brief The Scheduled Path Search for an attack. nullptr when we are not attacking.
+		 */
+		std::shared_ptr<PathTicket> pathTicket;
+
 	public:
 
 		/**
@@ -104,6 +128,36 @@ namespace pilot
 			targetNode = _targetNode;
 		}
 
+		const std::shared_ptr<FlowField>& GetFlowField() const
+		{
+			return flowField;
+		}
+
+		void SetFlowField(const std::shared_ptr<FlowField>& _flowField)
+		{
+			flowField = _flowField;
+		}
+
+		const std::shared_ptr<IncrementalPathPlanner>& GetPathPlanner() const
+		{
+			return pathPlanner;
+		}
+
+		void SetPathPlanner(const std::shared_ptr<IncrementalPathPlanner>& _pathPlanner)
+		{
+			pathPlanner = _pathPlanner;
+		}
+
+		const std::shared_ptr<PathTicket>& GetPathTicket() const
+		{
+			return pathTicket;
+		}
+
+		void SetPathTicket(const std::shared_ptr<PathTicket>& _pathTicket)
+		{
+			pathTicket = _pathTicket;
+		}
+
 		std::string GetEntityName() const
 		{
 			return entityName;
@@ -0,0 +1,138 @@
+﻿#include "FlowField.h"
+#include "Terrain.h"
+
+#include <queue>
+#include <functional>
+#include <climits>
+
+namespace pilot {
+
+	FlowField::FlowField(const std::vector<glm::ivec2>& _goalNodes)
+		: goalNodes(_goalNodes)
+	{
+	}
+
+	void FlowField::Build(const Terrain& _terrain)
+	{
+		nodeCountX = _terrain.GetNodeCountX();
+		nodeCountZ = _terrain.GetNodeCountZ();
+		obstacleVersion = _terrain.GetObstacleVersion();
+
+		const int tile_count = nodeCountX * nodeCountZ;
+
+		integrationField.assign(tile_count, float(INT_MAX));
+		directionField.assign(tile_count, -1);
+
+		// Dijkstra, going backwards from the Goal Region. The cost of stepping from A to B is the navCost of A.
+		typedef std::pair<float, int> QueueEntry;
+		std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> open_queue;
+
+		for (const auto& goal : goalNodes)
+		{
+			if (goal.x < 0 || goal.y < 0 || goal.x >= int(nodeCountX) || goal.y >= int(nodeCountZ))
+			{
+				continue;
+			}
+
+			const int goal_index = goal.x * nodeCountZ + goal.y;
+
+			if (_terrain.IsTilePassable(goal_index) && integrationField[goal_index] != 0.0f)
+			{
+				integrationField[goal_index] = 0.0f;
+				open_queue.push(QueueEntry(0.0f, goal_index));
+			}
+		}
+
+		while (!open_queue.empty())
+		{
+			const auto entry = open_queue.top();
+			open_queue.pop();
+
+			const int tile_index = entry.second;
+
+			// A stale entry. We already found a cheaper way here.
+			if (entry.first > integrationField[tile_index])
+			{
+				continue;
+			}
+
+			const MapTile * tile = _terrain.GetTileFromIndex(tile_index);
+
+			// You can leave a Tile you cannot step on ( if you were already standing there ), but you cannot pass through it.
+			if (!_terrain.IsTilePassable(tile_index))
+			{
+				continue;
+			}
+
+			for (auto k = 0; k < 8; k++)
+			{
+				const int from_x = tile->tileIndexX + MapTile::navDirectionOffsets[k].x;
+				const int from_z = tile->tileIndexZ + MapTile::navDirectionOffsets[k].y;
+
+				if (from_x < 0 || from_z < 0 || from_x >= int(nodeCountX) || from_z >= int(nodeCountZ))
+				{
+					continue;
+				}
+
+				// The Neighbour in Direction k steps onto this Tile in the opposite Direction.
+				const int from_index = _terrain.GetNeighbourIndex(tile_index, k);
+
+				if (!_terrain.GetTileFromIndex(from_index)->CanStep((k + 4) & 7))
+				{
+					continue;
+				}
+
+				const float new_cost = entry.first + _terrain.GetNavCost(from_index);
+
+				if (new_cost < integrationField[from_index])
+				{
+					integrationField[from_index] = new_cost;
+					open_queue.push(QueueEntry(new_cost, from_index));
+				}
+			}
+		}
+
+		// Every Tile points at its cheapest Neighbour. All the steps out of a Tile cost the same, so that is the one with the least Integration.
+		for (auto tile_index = 0; tile_index < tile_count; tile_index++)
+		{
+			if (integrationField[tile_index] == 0.0f || integrationField[tile_index] == float(INT_MAX))
+			{
+				continue;
+			}
+
+			const MapTile * tile = _terrain.GetTileFromIndex(tile_index);
+
+			float best_integration = float(INT_MAX);
+
+			for (auto direction = 0; direction < 8; direction++)
+			{
+				// You can only step onto Passable Tiles, so there is always a Tile there.
+				if (!tile->CanStep(direction))
+				{
+					continue;
+				}
+
+				const int to_index = _terrain.GetNeighbourIndex(tile_index, direction);
+
+				if (integrationField[to_index] < best_integration)
+				{
+					best_integration = integrationField[to_index];
+					directionField[tile_index] = direction;
+				}
+			}
+		}
+	}
+
+	int FlowField::GetNextTileIndex(int _tileIndex) const
+	{
+		const signed char direction = directionField[_tileIndex];
+
+		if (direction < 0)
+		{
+			return -1;
+		}
+
+		return _tileIndex + MapTile::navDirectionOffsets[direction].x * nodeCountZ + MapTile::navDirectionOffsets[direction].y;
+	}
+
+}
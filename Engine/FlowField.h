@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <glm/vec2.hpp>
+
+namespace pilot {
+
+	class Terrain;
+
+	/**
+	 * \brief A Flow Field ( Dijkstra Map ) towards a Goal Region on the Terrain.
+	 *
+	 * The Integration Field holds the cost to reach the closest Goal Tile from every Tile, and the Direction Field holds which
+	 * Neighbour to step onto next. Built once for a whole group, after which every unit can look up its next step in O(1).
+	 */
+	class FlowField
+	{
+
+		unsigned int nodeCountX = 0, nodeCountZ = 0;
+
+		/**
+		 * \brief The Goal Tiles, as Node Indices.
+		 */
+		std::vector<glm::ivec2> goalNodes;
+
+		/**
+		 * \brief Cost to reach the Goal Region from each Tile. INT_MAX if the Goal cannot be reached.
+		 */
+		std::vector<float> integrationField;
+
+		/**
+		 * \brief The Direction to step in, from each Tile. An index into MapTile::navDirectionOffsets. -1 for Goal Tiles and Tiles that cannot reach the Goal.
+		 */
+		std::vector<signed char> directionField;
+
+		/**
+		 * \brief The Obstacle Version of the Terrain, when this was built.
+		 */
+		unsigned int obstacleVersion = 0;
+
+	public:
+
+		FlowField() = default;
+
+		/**
+		 * \brief Create the Flow Field for the Goal Region. Call Build before using it.
+		 * \param _goalNodes The Node Indices of the Goal Tiles.
+		 */
+		explicit FlowField(const std::vector<glm::ivec2>& _goalNodes);
+
+		const std::vector<glm::ivec2>& GetGoalNodes() const
+		{
+			return goalNodes;
+		}
+
+		unsigned int GetObstacleVersion() const
+		{
+			return obstacleVersion;
+		}
+
+		/**
+		 * \brief Sweep the Terrain from the Goal Region and fill the Integration and Direction Fields.
+		 * \param _terrain The Terrain to build it over.
+		 */
+		void Build(const Terrain& _terrain);
+
+		/**
+		 * \brief Get the Cost to reach the Goal Region from a Tile.
+		 * \param _tileIndex The Index of the Tile.
+		 * \return The Integration value. 0 for Goal Tiles, INT_MAX if the Goal cannot be reached.
+		 */
+		float GetIntegration(int _tileIndex) const
+		{
+			return integrationField[_tileIndex];
+		}
+
+		/**
+		 * \brief Is this Tile one of the Goal Tiles.
+		 */
+		bool IsGoal(int _tileIndex) const
+		{
+			return integrationField[_tileIndex] == 0.0f;
+		}
+
+		/**
+		 * \brief Get the Tile to step onto next, from a Tile.
+		 * \param _tileIndex The Index of the Tile you are on.
+		 * \return The Index of the next Tile. -1 if you are on a Goal Tile or the Goal cannot be reached.
+		 */
+		int GetNextTileIndex(int _tileIndex) const;
+
+	};
+
+}
@@ -0,0 +1,220 @@
+#include "HeightQuadtree.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace pilot {
+
+	void HeightQuadtree::Build(const float * _heights, unsigned int _vertexCountX, unsigned int _vertexCountZ, int _leafSize)
+	{
+		vertexCountX = _vertexCountX;
+		vertexCountZ = _vertexCountZ;
+		leafSize = std::max(_leafSize, 1);
+
+		const int quads_x = std::max(int(vertexCountX) - 1, 1);
+		const int quads_z = std::max(int(vertexCountZ) - 1, 1);
+
+		unsigned int level_count = 1;
+		while ((leafSize << (level_count - 1)) < std::max(quads_x, quads_z))
+		{
+			level_count++;
+		}
+
+		nodeCounts.resize(level_count);
+		ranges.assign(level_count, std::vector<glm::vec2>());
+
+		for (unsigned int level = 0; level < level_count; level++)
+		{
+			const int node_size = GetNodeSize(level);
+			nodeCounts[level] = glm::ivec2((quads_x + node_size - 1) / node_size, (quads_z + node_size - 1) / node_size);
+			ranges[level].assign(nodeCounts[level].x * nodeCounts[level].y, glm::vec2(FLT_MAX, -FLT_MAX));
+		}
+
+		if (0 == vertexCountX || 0 == vertexCountZ)
+		{
+			return;
+		}
+
+		Refit(_heights, glm::ivec2(0), glm::ivec2(vertexCountX - 1, vertexCountZ - 1));
+	}
+
+	void HeightQuadtree::Grow(int _x, int _z, float _height)
+	{
+		for (int level = 0; level < int(ranges.size()); level++)
+		{
+			const int node_size = GetNodeSize(level);
+
+			// A Vertex on the Edge between two Nodes is in both.
+			for (auto node_x = std::max((_x - 1) / node_size, 0); node_x <= std::min(_x / node_size, nodeCounts[level].x - 1); node_x++)
+			{
+				for (auto node_z = std::max((_z - 1) / node_size, 0); node_z <= std::min(_z / node_size, nodeCounts[level].y - 1); node_z++)
+				{
+					glm::vec2& range = ranges[level][node_x * nodeCounts[level].y + node_z];
+					range.x = std::min(range.x, _height);
+					range.y = std::max(range.y, _height);
+				}
+			}
+		}
+	}
+
+	void HeightQuadtree::RefitLeaf(const float * _heights, int _x, int _z)
+	{
+		const glm::ivec2 first = GetFirstVertex(0, _x, _z);
+		const glm::ivec2 last = GetLastVertex(0, _x, _z);
+
+		glm::vec2 range(FLT_MAX, -FLT_MAX);
+
+		for (auto x = first.x; x <= last.x; x++)
+		{
+			const float * row = _heights + x * vertexCountZ;
+
+			for (auto z = first.y; z <= last.y; z++)
+			{
+				range.x = std::min(range.x, row[z]);
+				range.y = std::max(range.y, row[z]);
+			}
+		}
+
+		ranges[0][_x * nodeCounts[0].y + _z] = range;
+	}
+
+	void HeightQuadtree::RefitNode(int _level, int _x, int _z)
+	{
+		const glm::ivec2& child_count = nodeCounts[_level - 1];
+
+		glm::vec2 range(FLT_MAX, -FLT_MAX);
+
+		for (auto child_x = 2 * _x; child_x < std::min(2 * _x + 2, child_count.x); child_x++)
+		{
+			for (auto child_z = 2 * _z; child_z < std::min(2 * _z + 2, child_count.y); child_z++)
+			{
+				const glm::vec2& child_range = ranges[_level - 1][child_x * child_count.y + child_z];
+				range.x = std::min(range.x, child_range.x);
+				range.y = std::max(range.y, child_range.y);
+			}
+		}
+
+		ranges[_level][_x * nodeCounts[_level].y + _z] = range;
+	}
+
+	void HeightQuadtree::Refit(const float * _heights, glm::ivec2 _min, glm::ivec2 _max)
+	{
+		_min = glm::max(_min, glm::ivec2(0));
+		_max = glm::min(_max, glm::ivec2(vertexCountX - 1, vertexCountZ - 1));
+
+		if (ranges.empty() || _min.x > _max.x || _min.y > _max.y)
+		{
+			return;
+		}
+
+		// The Leaves with any of the Vertices in them, including the ones that only share an Edge.
+		glm::ivec2 first_node = glm::max((_min - 1) / leafSize, glm::ivec2(0));
+		glm::ivec2 last_node = glm::min(_max / leafSize, nodeCounts[0] - 1);
+
+		for (auto x = first_node.x; x <= last_node.x; x++)
+		{
+			for (auto z = first_node.y; z <= last_node.y; z++)
+			{
+				RefitLeaf(_heights, x, z);
+			}
+		}
+
+		// Their Parents, up to the Root.
+		for (int level = 1; level < int(ranges.size()); level++)
+		{
+			first_node /= 2;
+			last_node /= 2;
+
+			for (auto x = first_node.x; x <= last_node.x; x++)
+			{
+				for (auto z = first_node.y; z <= last_node.y; z++)
+				{
+					RefitNode(level, x, z);
+				}
+			}
+		}
+	}
+
+	void HeightQuadtree::FindHighestInNode(const float * _heights, int _level, int _x, int _z, const glm::ivec2& _min, const glm::ivec2& _max, glm::ivec2& _vertex, float& _height) const
+	{
+		const glm::ivec2 first = glm::max(GetFirstVertex(_level, _x, _z), _min);
+		const glm::ivec2 last = glm::min(GetLastVertex(_level, _x, _z), _max);
+
+		if (first.x > last.x || first.y > last.y || GetRange(_level, _x, _z).y <= _height)
+		{
+			return;
+		}
+
+		if (0 == _level)
+		{
+			for (auto x = first.x; x <= last.x; x++)
+			{
+				const float * row = _heights + x * vertexCountZ;
+
+				for (auto z = first.y; z <= last.y; z++)
+				{
+					if (row[z] > _height)
+					{
+						_height = row[z];
+						_vertex = glm::ivec2(x, z);
+					}
+				}
+			}
+
+			return;
+		}
+
+		// The highest Children first, so that the others are more likely to be skipped.
+		glm::ivec2 children[4];
+		int child_count = 0;
+
+		for (auto child_x = 2 * _x; child_x < std::min(2 * _x + 2, nodeCounts[_level - 1].x); child_x++)
+		{
+			for (auto child_z = 2 * _z; child_z < std::min(2 * _z + 2, nodeCounts[_level - 1].y); child_z++)
+			{
+				children[child_count++] = glm::ivec2(child_x, child_z);
+			}
+		}
+
+		std::sort(children, children + child_count, [this, _level](const glm::ivec2& _a, const glm::ivec2& _b)
+		{
+			return GetRange(_level - 1, _a.x, _a.y).y > GetRange(_level - 1, _b.x, _b.y).y;
+		});
+
+		for (auto i = 0; i < child_count; i++)
+		{
+			FindHighestInNode(_heights, _level - 1, children[i].x, children[i].y, _min, _max, _vertex, _height);
+		}
+	}
+
+	bool HeightQuadtree::FindHighest(const float * _heights, glm::ivec2 _min, glm::ivec2 _max, glm::ivec2& _vertex) const
+	{
+		_min = glm::max(_min, glm::ivec2(0));
+		_max = glm::min(_max, glm::ivec2(vertexCountX - 1, vertexCountZ - 1));
+
+		if (ranges.empty() || _min.x > _max.x || _min.y > _max.y)
+		{
+			return false;
+		}
+
+		float height = -FLT_MAX;
+		_vertex = _min;
+
+		FindHighestInNode(_heights, int(ranges.size()) - 1, 0, 0, _min, _max, _vertex, height);
+
+		return true;
+	}
+
+	size_t HeightQuadtree::GetMemoryUsage() const
+	{
+		size_t bytes = 0;
+
+		for (const auto& level : ranges)
+		{
+			bytes += level.capacity() * sizeof(glm::vec2);
+		}
+
+		return bytes;
+	}
+
+}
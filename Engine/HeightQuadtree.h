@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <glm/vec2.hpp>
+#include <glm/common.hpp>
+
+namespace pilot {
+
+	/**
+	 * \brief A Quadtree of the lowest and the highest Height in each square of a Grid of Heights.
+	 *
+	 * A Leaf covers leafSize by leafSize Quads, and each Level above it covers twice as many along each side, till the Root covers
+	 * the whole Grid. Only the Height Ranges are stored, 8 bytes a Node, so a 4k by 4k Grid with 16 Quad Leaves takes under 1 MB.
+	 * The Heights are not copied. They are passed in whenever they have to be read, X-Major, like the Tiles.
+	 */
+	class HeightQuadtree
+	{
+
+		unsigned int vertexCountX = 0, vertexCountZ = 0;
+
+		int leafSize = 1;
+
+		/**
+		 * \brief The Number of Nodes along X and Z, on each Level.
+		 */
+		std::vector<glm::ivec2> nodeCounts;
+
+		/**
+		 * \brief For each Level, the ( Lowest, Highest ) Height in each Node. X-Major.
+		 */
+		std::vector<std::vector<glm::vec2>> ranges;
+
+		/**
+		 * \brief Set the Range of a Leaf from the Heights under it. The last Vertex of a Node is the first of the next one.
+		 */
+		void RefitLeaf(const float * _heights, int _x, int _z);
+
+		/**
+		 * \brief Set the Range of a Node from its Children.
+		 */
+		void RefitNode(int _level, int _x, int _z);
+
+		void FindHighestInNode(const float * _heights, int _level, int _x, int _z, const glm::ivec2& _min, const glm::ivec2& _max, glm::ivec2& _vertex, float& _height) const;
+
+		template <typename Visitor>
+		void VisitNode(int _level, int _x, int _z, Visitor& _visitor) const
+		{
+			if (_x >= nodeCounts[_level].x || _z >= nodeCounts[_level].y)
+			{
+				return;
+			}
+
+			if (!_visitor(_level, GetFirstVertex(_level, _x, _z), GetLastVertex(_level, _x, _z), GetRange(_level, _x, _z)) || 0 == _level)
+			{
+				return;
+			}
+
+			VisitNode(_level - 1, 2 * _x, 2 * _z, _visitor);
+			VisitNode(_level - 1, 2 * _x + 1, 2 * _z, _visitor);
+			VisitNode(_level - 1, 2 * _x, 2 * _z + 1, _visitor);
+			VisitNode(_level - 1, 2 * _x + 1, 2 * _z + 1, _visitor);
+		}
+
+	public:
+
+		HeightQuadtree() = default;
+
+		/**
+		 * \brief Build the whole Tree.
+		 * \param _heights The Heights, X-Major.
+		 * \param _vertexCountX Number of Heights along X
+		 * \param _vertexCountZ Number of Heights along Z
+		 * \param _leafSize Number of Quads along each side of a Leaf
+		 */
+		void Build(const float * _heights, unsigned int _vertexCountX, unsigned int _vertexCountZ, int _leafSize);
+
+		/**
+		 * \brief Widen the Ranges of every Node the Vertex is in, to take its new Height. Cheap, but the Ranges can stay wider than
+		 * they have to be, till the Vertex is Refit.
+		 */
+		void Grow(int _x, int _z, float _height);
+
+		/**
+		 * \brief Set the Ranges of every Node over the Rectangle of Vertices to exactly what the Heights are now.
+		 * \param _heights The Heights, X-Major.
+		 * \param _min The first Vertex Indices ( X, Z ) in the Rectangle
+		 * \param _max The last Vertex Indices ( X, Z ) in the Rectangle
+		 */
+		void Refit(const float * _heights, glm::ivec2 _min, glm::ivec2 _max);
+
+		/**
+		 * \brief Find the highest Vertex in the Rectangle. Nodes that cannot beat the highest one found so far are skipped.
+		 * \param _heights The Heights, X-Major.
+		 * \param _min The first Vertex Indices ( X, Z ) in the Rectangle
+		 * \param _max The last Vertex Indices ( X, Z ) in the Rectangle
+		 * \param _vertex Set to the Indices of the highest Vertex.
+		 * \return false if the Rectangle is not on the Grid.
+		 */
+		bool FindHighest(const float * _heights, glm::ivec2 _min, glm::ivec2 _max, glm::ivec2& _vertex) const;
+
+		/**
+		 * \brief Go down the Tree from the Root, depth first.
+		 * \param _visitor Called as bool( int _level, glm::ivec2 _firstVertex, glm::ivec2 _lastVertex, glm::vec2 _range ) for each
+		 * Node. Its Children are visited only if it returns true.
+		 */
+		template <typename Visitor>
+		void Visit(Visitor _visitor) const
+		{
+			if (!ranges.empty())
+			{
+				VisitNode(int(ranges.size()) - 1, 0, 0, _visitor);
+			}
+		}
+
+		unsigned int GetLevelCount() const
+		{
+			return (unsigned int)ranges.size();
+		}
+
+		int GetLeafSize() const
+		{
+			return leafSize;
+		}
+
+		/**
+		 * \brief Number of Quads along each side of a Node on the Level.
+		 */
+		int GetNodeSize(int _level) const
+		{
+			return leafSize << _level;
+		}
+
+		const glm::ivec2& GetNodeCount(int _level) const
+		{
+			return nodeCounts[_level];
+		}
+
+		const glm::vec2& GetRange(int _level, int _x, int _z) const
+		{
+			return ranges[_level][_x * nodeCounts[_level].y + _z];
+		}
+
+		const glm::vec2& GetRootRange() const
+		{
+			return ranges.back()[0];
+		}
+
+		glm::ivec2 GetFirstVertex(int _level, int _x, int _z) const
+		{
+			return glm::ivec2(_x, _z) * GetNodeSize(_level);
+		}
+
+		glm::ivec2 GetLastVertex(int _level, int _x, int _z) const
+		{
+			return glm::ivec2(
+				glm::min((_x + 1) * GetNodeSize(_level), int(vertexCountX) - 1),
+				glm::min((_z + 1) * GetNodeSize(_level), int(vertexCountZ) - 1)
+			);
+		}
+
+		/**
+		 * \brief The Bytes held by the Ranges.
+		 */
+		size_t GetMemoryUsage() const;
+
+	};
+
+}
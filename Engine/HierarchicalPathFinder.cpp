@@ -0,0 +1,622 @@
+#include "HierarchicalPathFinder.h"
+#include "Terrain.h"
+#include "WorkerPool.h"
+
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+namespace pilot {
+
+	int HierarchicalPathFinder::GetClusterIndex(int _tileIndex) const
+	{
+		const int node_count_z = terrain->GetNodeCountZ();
+		const int x = _tileIndex / node_count_z;
+		const int z = _tileIndex % node_count_z;
+
+		return (x / clusterSize) * clusterCountZ + (z / clusterSize);
+	}
+
+	glm::ivec4 HierarchicalPathFinder::GetClusterBounds(int _clusterIndex) const
+	{
+		const int cluster_x = _clusterIndex / clusterCountZ;
+		const int cluster_z = _clusterIndex % clusterCountZ;
+
+		const int min_x = cluster_x * clusterSize;
+		const int min_z = cluster_z * clusterSize;
+
+		return glm::ivec4(
+			min_x,
+			min_z,
+			std::min<int>(min_x + clusterSize, terrain->GetNodeCountX()) - 1,
+			std::min<int>(min_z + clusterSize, terrain->GetNodeCountZ()) - 1
+		);
+	}
+
+	float HierarchicalPathFinder::Heuristic(int _fromTileIndex, int _toTileIndex) const
+	{
+		// Every step costs at least minNavCost, and you need at least Chebyshev Distance steps. So this never overestimates.
+		const int node_count_z = terrain->GetNodeCountZ();
+		const int dx = std::abs(_fromTileIndex / node_count_z - _toTileIndex / node_count_z);
+		const int dz = std::abs(_fromTileIndex % node_count_z - _toTileIndex % node_count_z);
+
+		return float(std::max(dx, dz)) * minNavCost;
+	}
+
+	void HierarchicalPathFinder::BuildBorder(int _clusterIndex, bool _alongX)
+	{
+		const int cluster_x = _clusterIndex / clusterCountZ;
+		const int cluster_z = _clusterIndex % clusterCountZ;
+
+		auto& border = _alongX ? bordersX[_clusterIndex] : bordersZ[_clusterIndex];
+		border.clear();
+
+		if ((_alongX && cluster_x + 1 >= int(clusterCountX)) || (!_alongX && cluster_z + 1 >= int(clusterCountZ)))
+		{
+			return;
+		}
+
+		const int other_cluster = _alongX ? _clusterIndex + clusterCountZ : _clusterIndex + 1;
+		const glm::ivec4 bounds = GetClusterBounds(_clusterIndex);
+
+		// Walk along the Border. We can cross at i, if we can step both ways between the Tiles on either side.
+		const int border_start = _alongX ? bounds.y : bounds.x;
+		const int border_end = _alongX ? bounds.w : bounds.z;
+
+		const int node_count_z = terrain->GetNodeCountZ();
+
+		auto get_pair = [&](int _i) -> std::pair<int, int>
+		{
+			if (_alongX)
+			{
+				return std::pair<int, int>(bounds.z * node_count_z + _i, (bounds.z + 1) * node_count_z + _i);
+			}
+			return std::pair<int, int>(_i * node_count_z + bounds.w, _i * node_count_z + bounds.w + 1);
+		};
+
+		// Crossing goes +X or +Z, and coming back is the opposite Direction.
+		const int cross_direction = _alongX ? 0 : 2;
+
+		auto can_cross = [&](int _i)
+		{
+			const auto pair = get_pair(_i);
+			return terrain->IsTilePassable(pair.first) && terrain->IsTilePassable(pair.second)
+				&& terrain->GetTileFromIndex(pair.first)->CanStep(cross_direction) && terrain->GetTileFromIndex(pair.second)->CanStep((cross_direction + 4) & 7);
+		};
+
+		int run_start = -1;
+
+		for (int i = border_start; i <= border_end + 1; i++)
+		{
+			const bool crossable = (i <= border_end) && can_cross(i);
+
+			if (crossable && run_start < 0)
+			{
+				run_start = i;
+			}
+			else if (!crossable && run_start >= 0)
+			{
+				// One Entrance in the middle of short runs, one at each end of the long ones.
+				const int run_end = i - 1;
+				if (run_end - run_start + 1 < 6)
+				{
+					border.push_back(get_pair((run_start + run_end) / 2));
+				}
+				else
+				{
+					border.push_back(get_pair(run_start));
+					border.push_back(get_pair(run_end));
+				}
+				run_start = -1;
+			}
+		}
+
+		clusters[_clusterIndex].dirty = true;
+		clusters[other_cluster].dirty = true;
+	}
+
+	void HierarchicalPathFinder::CollectEntrances(int _clusterIndex)
+	{
+		auto& cluster = clusters[_clusterIndex];
+
+		for (const auto entrance : cluster.entrances)
+		{
+			nodes.erase(entrance);
+		}
+		cluster.entrances.clear();
+
+		const int cluster_x = _clusterIndex / clusterCountZ;
+		const int cluster_z = _clusterIndex % clusterCountZ;
+
+		// Add an Entrance with an Edge across the Border. Stepping from A to B costs the navCost of A.
+		auto add_entrance = [&](int _from, int _to)
+		{
+			auto it = nodes.find(_from);
+			if (it == nodes.end())
+			{
+				it = nodes.emplace(_from, AbstractNode{ _clusterIndex, {} }).first;
+				cluster.entrances.push_back(_from);
+			}
+			it->second.edges.push_back(AbstractEdge{ _to, terrain->GetNavCost(_from) });
+		};
+
+		for (const auto& pair : bordersX[_clusterIndex])
+		{
+			add_entrance(pair.first, pair.second);
+		}
+
+		for (const auto& pair : bordersZ[_clusterIndex])
+		{
+			add_entrance(pair.first, pair.second);
+		}
+
+		if (cluster_x > 0)
+		{
+			for (const auto& pair : bordersX[_clusterIndex - clusterCountZ])
+			{
+				add_entrance(pair.second, pair.first);
+			}
+		}
+
+		if (cluster_z > 0)
+		{
+			for (const auto& pair : bordersZ[_clusterIndex - 1])
+			{
+				add_entrance(pair.second, pair.first);
+			}
+		}
+	}
+
+	void HierarchicalPathFinder::ConnectEntrances(int _clusterIndex, PathFindingContext& _context)
+	{
+		auto& cluster = clusters[_clusterIndex];
+		const glm::ivec4 bounds = GetClusterBounds(_clusterIndex);
+
+		for (const auto from : cluster.entrances)
+		{
+			SearchInBounds(_context, from, -1, bounds, false);
+
+			// The Node is already in the Map, so looking it up is safe from any thread.
+			auto& edges = nodes.find(from)->second.edges;
+
+			for (const auto to : cluster.entrances)
+			{
+				if (to == from)
+				{
+					continue;
+				}
+
+				const float cost = _context.GetNode(to).gCost;
+				if (cost < float(INT_MAX))
+				{
+					edges.push_back(AbstractEdge{ to, cost });
+				}
+			}
+		}
+
+		cluster.dirty = false;
+	}
+
+	void HierarchicalPathFinder::SearchInBounds(PathFindingContext& _context, int _sourceIndex, int _targetIndex, const glm::ivec4& _bounds, bool _backwards)
+	{
+		const int node_count_z = terrain->GetNodeCountZ();
+
+		_context.BeginSearch(size_t(terrain->GetNodeCountX()) * node_count_z);
+
+		SearchNode& source_node = _context.GetNode(_sourceIndex);
+		source_node.gCost = 0.0f;
+		source_node.fCost = (_targetIndex >= 0) ? Heuristic(_sourceIndex, _targetIndex) : 0.0f;
+		source_node.open = true;
+		_context.PushOpen(_sourceIndex);
+
+		while (!_context.IsOpenSetEmpty())
+		{
+			const int current_index = _context.PopOpen();
+			SearchNode& current_node = _context.GetNode(current_index);
+			current_node.open = false;
+			current_node.closed = true;
+			_context.CountExpansion();
+
+			if (current_index == _targetIndex)
+			{
+				return;
+			}
+
+			const MapTile * current = terrain->GetTileFromIndex(current_index);
+			const float current_g = current_node.gCost;
+
+			for (auto k = 0; k < 8; k++)
+			{
+				const int x = current->tileIndexX + MapTile::navDirectionOffsets[k].x;
+				const int z = current->tileIndexZ + MapTile::navDirectionOffsets[k].y;
+
+				if (x < _bounds.x || z < _bounds.y || x > _bounds.z || z > _bounds.w)
+				{
+					continue;
+				}
+
+				const int neighbour_index = terrain->GetNeighbourIndex(current_index, k);
+
+				if (!terrain->IsTilePassable(neighbour_index))
+				{
+					continue;
+				}
+
+				// Going backwards, we are looking for the Tiles that can step onto the Current one, in the opposite Direction.
+				const bool connected = _backwards ? terrain->GetTileFromIndex(neighbour_index)->CanStep((k + 4) & 7) : current->CanStep(k);
+				if (!connected)
+				{
+					continue;
+				}
+
+				SearchNode& neighbour_node = _context.GetNode(neighbour_index);
+				if (neighbour_node.closed)
+				{
+					continue;
+				}
+
+				const float new_g = current_g + terrain->GetNavCost(_backwards ? neighbour_index : current_index);
+				const float new_f = new_g + ((_targetIndex >= 0) ? Heuristic(neighbour_index, _targetIndex) : 0.0f);
+
+				if (!neighbour_node.open)
+				{
+					neighbour_node.gCost = new_g;
+					neighbour_node.fCost = new_f;
+					neighbour_node.parent = current_index;
+					neighbour_node.open = true;
+					_context.PushOpen(neighbour_index);
+				}
+				else if (new_g < neighbour_node.gCost)
+				{
+					neighbour_node.gCost = new_g;
+					neighbour_node.fCost = new_f;
+					neighbour_node.parent = current_index;
+					_context.DecreaseKey(neighbour_index);
+				}
+			}
+		}
+	}
+
+	void HierarchicalPathFinder::Update()
+	{
+		if (!anythingDirty)
+		{
+			return;
+		}
+
+		// The Borders first, as they decide which Clusters need rebuilding.
+		for (auto i = 0; i < int(clusters.size()); i++)
+		{
+			if (borderXDirty[i])
+			{
+				BuildBorder(i, true);
+				borderXDirty[i] = false;
+			}
+
+			if (borderZDirty[i])
+			{
+				BuildBorder(i, false);
+				borderZDirty[i] = false;
+			}
+		}
+
+		std::vector<int> dirty_clusters;
+		for (auto i = 0; i < int(clusters.size()); i++)
+		{
+			if (clusters[i].dirty)
+			{
+				CollectEntrances(i);
+				dirty_clusters.push_back(i);
+			}
+		}
+
+		// Each Cluster only touches its own Entrances, so they can be connected in parallel.
+		if (workerContexts.size() < WORKERPOOL.GetWorkerCount())
+		{
+			workerContexts.resize(WORKERPOOL.GetWorkerCount());
+		}
+
+		WORKERPOOL.ParallelFor(static_cast<unsigned int>(dirty_clusters.size()), [&](unsigned int _index, unsigned int _worker)
+		{
+			ConnectEntrances(dirty_clusters[_index], workerContexts[_worker]);
+		});
+
+		anythingDirty = false;
+	}
+
+	void HierarchicalPathFinder::Build(const Terrain& _terrain, unsigned int _clusterSize)
+	{
+		terrain = &_terrain;
+		clusterSize = std::max(_clusterSize, 2u);
+
+		clusterCountX = (terrain->GetNodeCountX() + clusterSize - 1) / clusterSize;
+		clusterCountZ = (terrain->GetNodeCountZ() + clusterSize - 1) / clusterSize;
+
+		const size_t cluster_count = size_t(clusterCountX) * clusterCountZ;
+
+		nodes.clear();
+		clusters.assign(cluster_count, Cluster());
+		bordersX.assign(cluster_count, std::vector<std::pair<int, int>>());
+		bordersZ.assign(cluster_count, std::vector<std::pair<int, int>>());
+		borderXDirty.assign(cluster_count, false);
+		borderZDirty.assign(cluster_count, false);
+
+		minNavCost = float(INT_MAX);
+		const int tile_count = int(terrain->GetNodeCountX() * terrain->GetNodeCountZ());
+		for (auto i = 0; i < tile_count; i++)
+		{
+			if (terrain->IsTileWalkable(i) && terrain->GetNavCost(i) > 0.0f)
+			{
+				minNavCost = std::min(minNavCost, terrain->GetNavCost(i));
+			}
+		}
+		if (minNavCost == float(INT_MAX))
+		{
+			minNavCost = 0.0f;
+		}
+
+		OnAllTilesChanged();
+		Update();
+	}
+
+	void HierarchicalPathFinder::OnTileChanged(int _x, int _z)
+	{
+		if (nullptr == terrain)
+		{
+			return;
+		}
+
+		const int cluster_x = _x / clusterSize;
+		const int cluster_z = _z / clusterSize;
+		const int cluster_index = cluster_x * clusterCountZ + cluster_z;
+
+		clusters[cluster_index].dirty = true;
+
+		// A Tile on a Border can open or close an Entrance. Rebuilding the Border marks both Clusters on it.
+		const glm::ivec4 bounds = GetClusterBounds(cluster_index);
+
+		if (_x == bounds.z)
+		{
+			borderXDirty[cluster_index] = true;
+		}
+		if (_x == bounds.x && cluster_x > 0)
+		{
+			borderXDirty[cluster_index - clusterCountZ] = true;
+		}
+		if (_z == bounds.w)
+		{
+			borderZDirty[cluster_index] = true;
+		}
+		if (_z == bounds.y && cluster_z > 0)
+		{
+			borderZDirty[cluster_index - 1] = true;
+		}
+
+		anythingDirty = true;
+	}
+
+	void HierarchicalPathFinder::OnAllTilesChanged()
+	{
+		std::fill(borderXDirty.begin(), borderXDirty.end(), true);
+		std::fill(borderZDirty.begin(), borderZDirty.end(), true);
+
+		for (auto& cluster : clusters)
+		{
+			cluster.dirty = true;
+		}
+
+		anythingDirty = true;
+	}
+
+	HierarchicalPath HierarchicalPathFinder::FindPath(const MapTile * _startTile, const MapTile * _endTile)
+	{
+		HierarchicalPath path;
+		lastExpansions = 0;
+
+		if (nullptr == terrain)
+		{
+			return path;
+		}
+
+		Update();
+
+		// Same rules as GetPathFromTiles.
+		if (!terrain->AreTilesConnected(_startTile, _endTile) || !terrain->IsTilePassable(_endTile) || _startTile == _endTile)
+		{
+			return path;
+		}
+
+		const int start_index = terrain->GetTileIndex(_startTile);
+		const int end_index = terrain->GetTileIndex(_endTile);
+		const int start_cluster = GetClusterIndex(start_index);
+		const int end_cluster = GetClusterIndex(end_index);
+
+		// Nothing to gain from the Abstract Graph for short queries.
+		if (start_cluster == end_cluster)
+		{
+			path.tiles = terrain->GetPathFromTiles(_startTile, _endTile, context);
+			if (!path.tiles.empty())
+			{
+				path.waypoints = { start_index, end_index };
+				path.nextSegment = 1;
+			}
+			return path;
+		}
+
+		// Connect the Start and the End to the Entrances of their Clusters.
+		std::vector<AbstractEdge> start_edges;
+		SearchInBounds(context, start_index, -1, GetClusterBounds(start_cluster), false);
+		for (const auto entrance : clusters[start_cluster].entrances)
+		{
+			const float cost = context.GetNode(entrance).gCost;
+			if (cost < float(INT_MAX))
+			{
+				start_edges.push_back(AbstractEdge{ entrance, cost });
+			}
+		}
+
+		std::unordered_map<int, float> end_costs;
+		SearchInBounds(context, end_index, -1, GetClusterBounds(end_cluster), true);
+		for (const auto entrance : clusters[end_cluster].entrances)
+		{
+			const float cost = context.GetNode(entrance).gCost;
+			if (cost < float(INT_MAX))
+			{
+				end_costs[entrance] = cost;
+			}
+		}
+
+		// A* on the Abstract Graph. The Abstract Nodes are Tiles, so the Context can hold the Search State, same as for the Tiles.
+		context.BeginSearch(size_t(terrain->GetNodeCountX()) * terrain->GetNodeCountZ());
+
+		SearchNode& start_node = context.GetNode(start_index);
+		start_node.gCost = 0.0f;
+		start_node.fCost = Heuristic(start_index, end_index);
+		start_node.open = true;
+		context.PushOpen(start_index);
+
+		auto relax = [&](int _from, int _to, float _cost)
+		{
+			const float new_g = context.GetNode(_from).gCost + _cost;
+			SearchNode& to_node = context.GetNode(_to);
+
+			if (to_node.closed)
+			{
+				return;
+			}
+
+			if (!to_node.open)
+			{
+				to_node.gCost = new_g;
+				to_node.fCost = new_g + Heuristic(_to, end_index);
+				to_node.parent = _from;
+				to_node.open = true;
+				context.PushOpen(_to);
+			}
+			else if (new_g < to_node.gCost)
+			{
+				to_node.gCost = new_g;
+				to_node.fCost = new_g + Heuristic(_to, end_index);
+				to_node.parent = _from;
+				context.DecreaseKey(_to);
+			}
+		};
+
+		bool found = false;
+
+		while (!context.IsOpenSetEmpty())
+		{
+			const int current_index = context.PopOpen();
+			SearchNode& current_node = context.GetNode(current_index);
+			current_node.open = false;
+			current_node.closed = true;
+			context.CountExpansion();
+
+			if (current_index == end_index)
+			{
+				found = true;
+				break;
+			}
+
+			if (current_index == start_index)
+			{
+				for (const auto& edge : start_edges)
+				{
+					relax(current_index, edge.to, edge.cost);
+				}
+			}
+
+			const auto node = nodes.find(current_index);
+			if (node != nodes.end())
+			{
+				for (const auto& edge : node->second.edges)
+				{
+					relax(current_index, edge.to, edge.cost);
+				}
+			}
+
+			const auto end_cost = end_costs.find(current_index);
+			if (end_cost != end_costs.end())
+			{
+				relax(current_index, end_index, end_cost->second);
+			}
+		}
+
+		lastExpansions = context.GetLastExpansions();
+
+		// Every Border crossing can reach an Entrance on it, so if the Abstract Graph has no Path, there is none.
+		if (!found)
+		{
+			return path;
+		}
+
+		std::vector<int> waypoints;
+		for (int index = end_index; index != start_index; index = context.GetNode(index).parent)
+		{
+			waypoints.push_back(index);
+		}
+		waypoints.push_back(start_index);
+		std::reverse(waypoints.begin(), waypoints.end());
+
+		path.waypoints = std::move(waypoints);
+		path.nextSegment = 0;
+
+		Refine(path, 1);
+
+		return path;
+	}
+
+	void HierarchicalPathFinder::Refine(HierarchicalPath& _path, unsigned int _segmentCount)
+	{
+		if (nullptr == terrain)
+		{
+			return;
+		}
+
+		while (_segmentCount-- > 0 && !_path.IsFullyRefined())
+		{
+			const int from_index = _path.waypoints[_path.nextSegment];
+			const int to_index = _path.waypoints[_path.nextSegment + 1];
+
+			// The End first, so that the first step stays at the back.
+			std::vector<MapTile *> segment;
+
+			const int from_cluster = GetClusterIndex(from_index);
+
+			if (from_cluster != GetClusterIndex(to_index))
+			{
+				// Across a Border. That is a single step.
+				segment.push_back(terrain->GetTileFromIndex(to_index));
+			}
+			else
+			{
+				SearchInBounds(context, from_index, to_index, GetClusterBounds(from_cluster), false);
+
+				if (context.GetNode(to_index).closed)
+				{
+					for (int index = to_index; index != from_index; index = context.GetNode(index).parent)
+					{
+						segment.push_back(terrain->GetTileFromIndex(index));
+					}
+				}
+				else
+				{
+					// The Cluster changed under us. Leave it and search the whole Terrain.
+					segment = terrain->GetPathFromTiles(terrain->GetTileFromIndex(from_index), terrain->GetTileFromIndex(to_index), context);
+
+					if (segment.empty())
+					{
+						_path = HierarchicalPath();
+						return;
+					}
+				}
+			}
+
+			_path.tiles.insert(_path.tiles.begin(), segment.begin(), segment.end());
+			_path.nextSegment++;
+		}
+	}
+
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <unordered_map>
+#include <glm/vec4.hpp>
+
+#include "PathFindingContext.h"
+
+namespace pilot {
+
+	class Terrain;
+	class MapTile;
+
+	/**
+	 * \brief A Path found on the Abstract Graph, refined into Tiles a few Segments at a time.
+	 */
+	struct HierarchicalPath
+	{
+		/**
+		 * \brief Indices of the Tiles the Path goes through on the Abstract Graph. Start first, End last.
+		 */
+		std::vector<int> waypoints;
+
+		/**
+		 * \brief The Segment ( waypoints[i] -> waypoints[i + 1] ) to refine next.
+		 */
+		size_t nextSegment = 0;
+
+		/**
+		 * \brief The Refined Tiles, in the same order as GetPathFromTiles: the first step is at the back.
+		 */
+		std::vector<MapTile *> tiles;
+
+		bool IsEmpty() const
+		{
+			return waypoints.empty();
+		}
+
+		bool IsFullyRefined() const
+		{
+			return nextSegment + 1 >= waypoints.size();
+		}
+	};
+
+	/**
+	 * \brief Hierarchical Path Finding ( HPA* ) over the Terrain Tiles.
+	 *
+	 * The Terrain is split into square Clusters. Where two neighbouring Clusters can be crossed, we place Entrances on both sides,
+	 * and connect every pair of Entrances in a Cluster with the cost of the cheapest Path between them, inside the Cluster.
+	 * Long queries are first answered on this small Abstract Graph, and only the Segments we are about to walk are refined into Tiles.
+	 *
+	 * When a Tile changes, only its Cluster ( and the Cluster across the border, if the Tile is on one ) is rebuilt.
+	 */
+	class HierarchicalPathFinder
+	{
+
+		struct AbstractEdge
+		{
+			int to;
+			float cost;
+		};
+
+		struct AbstractNode
+		{
+			int cluster;
+			std::vector<AbstractEdge> edges;
+		};
+
+		struct Cluster
+		{
+			/**
+			 * \brief The Tile Indices of the Entrances in this Cluster.
+			 */
+			std::vector<int> entrances;
+			bool dirty = false;
+		};
+
+		const Terrain * terrain = nullptr;
+
+		unsigned int clusterSize = 16;
+		unsigned int clusterCountX = 0, clusterCountZ = 0;
+
+		/**
+		 * \brief The Abstract Graph, keyed by Tile Index.
+		 */
+		std::unordered_map<int, AbstractNode> nodes;
+
+		std::vector<Cluster> clusters;
+
+		/**
+		 * \brief For each Cluster, the ( this side, other side ) Tile pairs of the Entrances to the Cluster at +X.
+		 */
+		std::vector<std::vector<std::pair<int, int>>> bordersX;
+
+		/**
+		 * \brief For each Cluster, the ( this side, other side ) Tile pairs of the Entrances to the Cluster at +Z.
+		 */
+		std::vector<std::vector<std::pair<int, int>>> bordersZ;
+
+		std::vector<bool> borderXDirty;
+		std::vector<bool> borderZDirty;
+
+		bool anythingDirty = false;
+
+		/**
+		 * \brief The least navCost on the Terrain. Used to keep the Heuristic admissible.
+		 */
+		float minNavCost = 0.1f;
+
+		/**
+		 * \brief The Search State used by the Queries.
+		 */
+		PathFindingContext context;
+
+		/**
+		 * \brief One Search State for each Worker of the Worker Pool, used when rebuilding Clusters.
+		 */
+		std::vector<PathFindingContext> workerContexts;
+
+		/**
+		 * \brief Number of Abstract Nodes expanded by the last FindPath.
+		 */
+		unsigned int lastExpansions = 0;
+
+		int GetClusterIndex(int _tileIndex) const;
+
+		/**
+		 * \brief Bounds of the Cluster as ( min x, min z, max x, max z ), all inclusive.
+		 */
+		glm::ivec4 GetClusterBounds(int _clusterIndex) const;
+
+		float Heuristic(int _fromTileIndex, int _toTileIndex) const;
+
+		/**
+		 * \brief Find the Entrances on the border between a Cluster and the next one along X ( or Z ).
+		 */
+		void BuildBorder(int _clusterIndex, bool _alongX);
+
+		/**
+		 * \brief Recreate the Abstract Nodes of a Cluster from the Entrances on its Borders, with the Edges across them.
+		 */
+		void CollectEntrances(int _clusterIndex);
+
+		/**
+		 * \brief Add the Edges between the Entrances of a Cluster, with the cost of the cheapest Path between them inside it.
+		 * \param _clusterIndex The Cluster. Its Entrances must already be collected.
+		 * \param _context The Search State to use. One per thread.
+		 */
+		void ConnectEntrances(int _clusterIndex, PathFindingContext& _context);
+
+		/**
+		 * \brief Search from _sourceIndex, staying inside _bounds. The costs are left in the Context.
+		 * \param _context The Search State to use.
+		 * \param _sourceIndex The Tile to search from.
+		 * \param _targetIndex The Tile to search for. -1 searches the whole area ( Dijkstra ).
+		 * \param _bounds The area to stay in, as ( min x, min z, max x, max z ).
+		 * \param _backwards If true, the costs are of going from each Tile to the Source, instead of from the Source to each Tile.
+		 */
+		void SearchInBounds(PathFindingContext& _context, int _sourceIndex, int _targetIndex, const glm::ivec4& _bounds, bool _backwards);
+
+		/**
+		 * \brief Rebuild whatever was marked dirty since the last time.
+		 */
+		void Update();
+
+	public:
+
+		HierarchicalPathFinder() = default;
+
+		unsigned int GetClusterSize() const
+		{
+			return clusterSize;
+		}
+
+		size_t GetAbstractNodeCount() const
+		{
+			return nodes.size();
+		}
+
+		unsigned int GetLastExpansions() const
+		{
+			return lastExpansions;
+		}
+
+		/**
+		 * \brief Build the Clusters, Entrances and the Abstract Graph for the whole Terrain.
+		 * \param _terrain The Terrain. It must outlive this.
+		 * \param _clusterSize Number of Tiles along each side of a Cluster.
+		 */
+		void Build(const Terrain& _terrain, unsigned int _clusterSize = 16);
+
+		/**
+		 * \brief Let the Hierarchy know that a Tile changed ( Obstacle added or removed ). Its Cluster gets rebuilt before the next query.
+		 * \param _x Node Index X
+		 * \param _z Node Index Z
+		 */
+		void OnTileChanged(int _x, int _z);
+
+		/**
+		 * \brief Let the Hierarchy know that every Tile might have changed.
+		 */
+		void OnAllTilesChanged();
+
+		/**
+		 * \brief Find a Path on the Abstract Graph and refine its first Segment.
+		 * \param _startTile The Map Tile where you start
+		 * \param _endTile The Map Tile where you end
+		 * \return The Path. Empty if there is no Path.
+		 */
+		HierarchicalPath FindPath(const MapTile * _startTile, const MapTile * _endTile);
+
+		/**
+		 * \brief Refine the next few Segments of the Path into Tiles.
+		 * \param _path The Path to refine.
+		 * \param _segmentCount The Number of Segments to refine.
+		 */
+		void Refine(HierarchicalPath& _path, unsigned int _segmentCount = 1);
+
+	};
+
+}
@@ -0,0 +1,352 @@
+#include "IncrementalPathPlanner.h"
+#include "Terrain.h"
+
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+
+namespace pilot {
+
+	static const float PLANNER_INFINITY = float(INT_MAX);
+
+	// How far past the Start's Key, relative to it, a Search carries on. See ComputePath.
+	static const float KEY_TOLERANCE = 1e-4f;
+
+	IncrementalPathPlanner::PlannerNode& IncrementalPathPlanner::GetNode(int _tileIndex)
+	{
+		PlannerNode& node = nodes[_tileIndex];
+
+		if (node.generation != generation)
+		{
+			node.g = PLANNER_INFINITY;
+			node.rhs = PLANNER_INFINITY;
+			node.open = false;
+			node.generation = generation;
+		}
+
+		return node;
+	}
+
+	float IncrementalPathPlanner::GetG(int _tileIndex) const
+	{
+		const PlannerNode& node = nodes[_tileIndex];
+		return (node.generation != generation) ? PLANNER_INFINITY : node.g;
+	}
+
+	float IncrementalPathPlanner::Heuristic(int _fromTileIndex, int _toTileIndex) const
+	{
+		// Has to be consistent for the Keys to work, so we cannot use HCost here.
+		return terrain->GetPathCostLowerBound(_fromTileIndex, _toTileIndex);
+	}
+
+	IncrementalPathPlanner::Key IncrementalPathPlanner::CalculateKey(int _tileIndex)
+	{
+		const PlannerNode& node = GetNode(_tileIndex);
+		const float min_cost = std::min(node.g, node.rhs);
+
+		return Key(min_cost + Heuristic(startIndex, _tileIndex) + keyModifier, min_cost);
+	}
+
+	void IncrementalPathPlanner::UpdateVertex(int _tileIndex)
+	{
+		if (_tileIndex != goalIndex)
+		{
+			const MapTile * tile = terrain->GetTileFromIndex(_tileIndex);
+
+			float rhs = PLANNER_INFINITY;
+
+			for (auto i = 0; i < 8; i++)
+			{
+				if (tile->CanStep(i))
+				{
+					rhs = std::min(rhs, terrain->GetNavCost(_tileIndex) + GetG(terrain->GetNeighbourIndex(_tileIndex, i)));
+				}
+			}
+
+			GetNode(_tileIndex).rhs = rhs;
+		}
+
+		PlannerNode& node = GetNode(_tileIndex);
+
+		// Removing from the Queue is lazy. The entry stays, but it no longer matches the Node.
+		node.open = false;
+
+		if (node.g != node.rhs)
+		{
+			node.key = CalculateKey(_tileIndex);
+			node.open = true;
+			openQueue.push(std::make_pair(node.key, _tileIndex));
+		}
+	}
+
+	void IncrementalPathPlanner::UpdatePredecessors(int _tileIndex)
+	{
+		const MapTile * tile = terrain->GetTileFromIndex(_tileIndex);
+
+		// Every Tile around it, including the ones that just lost their step onto it.
+		for (const auto& offset : MapTile::navDirectionOffsets)
+		{
+			const int x = tile->tileIndexX + offset.x;
+			const int z = tile->tileIndexZ + offset.y;
+
+			if (x >= 0 && z >= 0 && x < int(terrain->GetNodeCountX()) && z < int(terrain->GetNodeCountZ()))
+			{
+				UpdateVertex(x * terrain->GetNodeCountZ() + z);
+			}
+		}
+	}
+
+	void IncrementalPathPlanner::Reset(const Terrain& _terrain, int _startIndex, int _goalIndex)
+	{
+		terrain = &_terrain;
+		startIndex = _startIndex;
+		lastStartIndex = _startIndex;
+		goalIndex = _goalIndex;
+		keyModifier = 0.0f;
+
+		appliedChangeCount = terrain->GetObstacleChanges().size();
+		obstacleEpoch = terrain->GetObstacleEpoch();
+
+		const size_t tile_count = size_t(terrain->GetNodeCountX()) * terrain->GetNodeCountZ();
+
+		if (nodes.size() != tile_count)
+		{
+			nodes.assign(tile_count, PlannerNode());
+			generation = 0;
+		}
+
+		generation++;
+
+		// When the counter wraps around, stale stamps could match again. Clear them all, once every 4 billion Resets.
+		if (0 == generation)
+		{
+			for (auto& node : nodes)
+			{
+				node.generation = 0;
+			}
+
+			generation = 1;
+		}
+
+		openQueue = decltype(openQueue)();
+
+		InvalidatePath();
+
+		PlannerNode& goal_node = GetNode(goalIndex);
+		goal_node.rhs = 0.0f;
+		goal_node.key = CalculateKey(goalIndex);
+		goal_node.open = true;
+		openQueue.push(std::make_pair(goal_node.key, goalIndex));
+	}
+
+	void IncrementalPathPlanner::MoveStart(int _startIndex)
+	{
+		if (_startIndex == startIndex)
+		{
+			return;
+		}
+
+		startIndex = _startIndex;
+
+		// Still on the Path, so it stays the cheapest way from here. Drop the Tiles, and the corners, we have walked past.
+		if (isPathValid && std::find(path.begin(), path.end(), terrain->GetTileFromIndex(startIndex)) != path.end())
+		{
+			while (terrain->GetTileIndex(path.back()) != startIndex)
+			{
+				if (!corners.empty() && corners.back() == path.back())
+				{
+					corners.pop_back();
+				}
+
+				path.pop_back();
+			}
+
+			if (!corners.empty() && corners.back() == path.back())
+			{
+				corners.pop_back();
+			}
+
+			path.pop_back();
+		}
+		else
+		{
+			InvalidatePath();
+		}
+
+		// The Heuristic to every Tile dropped by at most this much. Adding it to the new Keys keeps the old ones valid lower bounds.
+		keyModifier += Heuristic(lastStartIndex, startIndex);
+		lastStartIndex = startIndex;
+	}
+
+	void IncrementalPathPlanner::UpdateObstacles()
+	{
+		if (nullptr == terrain)
+		{
+			return;
+		}
+
+		if (terrain->GetObstacleEpoch() != obstacleEpoch)
+		{
+			Reset(*terrain, startIndex, goalIndex);
+			return;
+		}
+
+		const auto& changes = terrain->GetObstacleChanges();
+
+		if (appliedChangeCount < changes.size())
+		{
+			InvalidatePath();
+		}
+
+		// Every step onto a new Obstacle just got infinitely expensive.
+		for (; appliedChangeCount < changes.size(); appliedChangeCount++)
+		{
+			UpdatePredecessors(changes[appliedChangeCount]);
+		}
+	}
+
+	bool IncrementalPathPlanner::ComputePath()
+	{
+		lastExpansions = 0;
+
+		if (nullptr == terrain)
+		{
+			return false;
+		}
+
+		// The Tile Sets tell us for free if there is no Path. That would otherwise be a search of everything we can reach.
+		if (startIndex == goalIndex || !terrain->AreTilesConnected(terrain->GetTileFromIndex(startIndex), terrain->GetTileFromIndex(goalIndex)))
+		{
+			return startIndex == goalIndex;
+		}
+
+		while (!openQueue.empty())
+		{
+			const auto top = openQueue.top();
+			const int current_index = top.second;
+			PlannerNode& current_node = GetNode(current_index);
+
+			if (!current_node.open || current_node.key != top.first)
+			{
+				openQueue.pop();
+				continue;
+			}
+
+			// With the Landmarks, the Heuristic is exact along a lot of Paths, so the Keys on the Path tie with the Start's, and
+			// rounding can put them just above it. Carry on a little past the Start's Key, so that they still get expanded.
+			Key start_key = CalculateKey(startIndex);
+			start_key.first += KEY_TOLERANCE * std::max(start_key.first, 1.0f);
+
+			const PlannerNode& start_node = GetNode(startIndex);
+			if (!(top.first < start_key) && start_node.rhs == start_node.g)
+			{
+				break;
+			}
+
+			openQueue.pop();
+			lastExpansions++;
+
+			const Key new_key = CalculateKey(current_index);
+
+			if (top.first < new_key)
+			{
+				// The Start moved since this was queued.
+				current_node.key = new_key;
+				openQueue.push(std::make_pair(new_key, current_index));
+			}
+			else if (current_node.g > current_node.rhs)
+			{
+				current_node.g = current_node.rhs;
+				current_node.open = false;
+				UpdatePredecessors(current_index);
+			}
+			else
+			{
+				current_node.g = PLANNER_INFINITY;
+				UpdateVertex(current_index);
+				UpdatePredecessors(current_index);
+			}
+		}
+
+		return GetG(startIndex) < PLANNER_INFINITY;
+	}
+
+	const std::vector<MapTile *>& IncrementalPathPlanner::GetPath()
+	{
+		if (!isPathValid)
+		{
+			path = BuildPath();
+			isPathValid = true;
+			areCornersValid = false;
+		}
+
+		return path;
+	}
+
+	const std::vector<MapTile *>& IncrementalPathPlanner::GetCorners()
+	{
+		if (!areCornersValid)
+		{
+			const auto& tiles = GetPath();
+			corners = (nullptr == terrain) ? tiles : terrain->SmoothPath(terrain->GetTileFromIndex(startIndex), tiles);
+			areCornersValid = true;
+		}
+
+		return corners;
+	}
+
+	std::vector<MapTile *> IncrementalPathPlanner::BuildPath() const
+	{
+		std::vector<MapTile *> built_path;
+
+		if (nullptr == terrain || startIndex == goalIndex || GetG(startIndex) >= PLANNER_INFINITY)
+		{
+			return built_path;
+		}
+
+		// Walk down the g values, from the Start to the Goal.
+		int current_index = startIndex;
+
+		while (current_index != goalIndex && built_path.size() <= nodes.size())
+		{
+			const MapTile * current = terrain->GetTileFromIndex(current_index);
+
+			int best_index = -1;
+			float best_cost = PLANNER_INFINITY;
+
+			for (auto i = 0; i < 8; i++)
+			{
+				if (!current->CanStep(i))
+				{
+					continue;
+				}
+
+				const int successor_index = terrain->GetNeighbourIndex(current_index, i);
+				const float cost = terrain->GetNavCost(current_index) + GetG(successor_index);
+
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_index = successor_index;
+				}
+			}
+
+			if (best_index < 0)
+			{
+				return std::vector<MapTile *>();
+			}
+
+			built_path.push_back(terrain->GetTileFromIndex(best_index));
+			current_index = best_index;
+		}
+
+		if (current_index != goalIndex)
+		{
+			return std::vector<MapTile *>();
+		}
+
+		std::reverse(built_path.begin(), built_path.end());
+		return built_path;
+	}
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <queue>
+#include <functional>
+
+namespace pilot {
+
+	class Terrain;
+	class MapTile;
+
+	/**
+	 * \brief An Incremental Path Planner ( D* Lite ) for a single moving unit.
+	 *
+	 * The Search runs backwards, from the Goal to the unit. When Obstacles are added, only the Tiles whose steps got more expensive
+	 * ( and whatever depended on them ) are repaired, instead of searching from scratch. The unit moving along does not need a new
+	 * Search either, as the Goal stays the root of the Search Tree.
+	 *
+	 * The State is one Node per Tile, like in the PathFindingContext, so a Planner costs 24 Bytes a Tile. Only give one to a unit
+	 * that is actually going somewhere. Starting over only bumps the Generation, the Nodes are not cleared.
+	 */
+	class IncrementalPathPlanner
+	{
+
+		typedef std::pair<float, float> Key;
+
+		struct PlannerNode
+		{
+			float g;
+			float rhs;
+
+			/**
+			 * \brief The Key it was last put in the Open Queue with. Entries in the Queue with a different Key are stale.
+			 */
+			Key key;
+
+			/**
+			 * \brief The Generation this Node was last touched in. If it is not the current one, the Node counts as reset.
+			 */
+			unsigned int generation = 0;
+
+			bool open = false;
+		};
+
+		const Terrain * terrain = nullptr;
+
+		int startIndex = -1;
+		int goalIndex = -1;
+
+		/**
+		 * \brief Where the Start was when the Keys were last fixed. See keyModifier.
+		 */
+		int lastStartIndex = -1;
+
+		/**
+		 * \brief Added to the Keys instead of recomputing all of them, every time the Start moves.
+		 */
+		float keyModifier = 0.0f;
+
+		/**
+		 * \brief How many entries of the Terrain's Obstacle Change Log we have already applied.
+		 */
+		size_t appliedChangeCount = 0;
+
+		/**
+		 * \brief The Terrain's Obstacle Epoch when we started. If it changed, the Change Log was cleared, and we start over.
+		 */
+		unsigned int obstacleEpoch = 0;
+
+		/**
+		 * \brief One Node for each Tile, by Tile Index.
+		 */
+		std::vector<PlannerNode> nodes;
+
+		/**
+		 * \brief Incremented on every Reset. Nodes with a different generation are stale.
+		 */
+		unsigned int generation = 0;
+
+		std::priority_queue<std::pair<Key, int>, std::vector<std::pair<Key, int>>, std::greater<std::pair<Key, int>>> openQueue;
+
+		unsigned int lastExpansions = 0;
+
+		/**
+		 * \brief The Path from the Start, the first step at the back. Trimmed as the unit walks along it, and built again only when
+		 * the Goal changes, an Obstacle is placed, or the unit steps off it.
+		 */
+		std::vector<MapTile *> path;
+
+		/**
+		 * \brief The corners of the Path, from Terrain::SmoothPath. Trimmed along with it.
+		 */
+		std::vector<MapTile *> corners;
+
+		bool isPathValid = false;
+		bool areCornersValid = false;
+
+		/**
+		 * \brief Get the Node of a Tile, resetting it first if it is stale.
+		 */
+		PlannerNode& GetNode(int _tileIndex);
+
+		float GetG(int _tileIndex) const;
+
+		float Heuristic(int _fromTileIndex, int _toTileIndex) const;
+
+		Key CalculateKey(int _tileIndex);
+
+		/**
+		 * \brief Recompute the rhs of a Tile from its Successors, and put it in the Open Queue if it is inconsistent.
+		 */
+		void UpdateVertex(int _tileIndex);
+
+		/**
+		 * \brief Update every Tile that can step onto _tileIndex.
+		 */
+		void UpdatePredecessors(int _tileIndex);
+
+		/**
+		 * \brief Walk down the g values, from the Start to the Goal.
+		 */
+		std::vector<MapTile *> BuildPath() const;
+
+		void InvalidatePath()
+		{
+			isPathValid = false;
+			areCornersValid = false;
+		}
+
+	public:
+
+		IncrementalPathPlanner() = default;
+
+		int GetGoalIndex() const
+		{
+			return goalIndex;
+		}
+
+		unsigned int GetLastExpansions() const
+		{
+			return lastExpansions;
+		}
+
+		/**
+		 * \brief Forget everything, and plan from _startIndex to _goalIndex.
+		 * \param _terrain The Terrain. It must outlive this.
+		 * \param _startIndex The Index of the Tile the unit is on.
+		 * \param _goalIndex The Index of the Tile to go to.
+		 */
+		void Reset(const Terrain& _terrain, int _startIndex, int _goalIndex);
+
+		/**
+		 * \brief The unit moved. Cheap, the Search Tree stays as it is. If it is still on the Path, the Path is only trimmed.
+		 * \param _startIndex The Index of the Tile the unit is on now.
+		 */
+		void MoveStart(int _startIndex);
+
+		/**
+		 * \brief Apply the Obstacles added to the Terrain since the last call.
+		 */
+		void UpdateObstacles();
+
+		/**
+		 * \brief Repair the Search until the Start is consistent.
+		 * \return False if there is no Path.
+		 */
+		bool ComputePath();
+
+		/**
+		 * \brief Get the Path from the Start to the Goal. Call ComputePath first.
+		 * \return A Vector of Tiles, in the same order as GetPathFromTiles: the first step is at the back. Empty if there is no Path.
+		 */
+		const std::vector<MapTile *>& GetPath();
+
+		/**
+		 * \brief Get the corners of the Path, as Terrain::SmoothPath gives them. Only smoothed again when the Path is built again.
+		 */
+		const std::vector<MapTile *>& GetCorners();
+
+	};
+
+}
@@ -130,4 +130,25 @@ namespace pilot
 		PE_GL(glBufferData(GL_ARRAY_BUFFER, _dataStructureSize * _vertexCount, _dataPointer, GL_STATIC_DRAW));
 
 	}
+
+	void Mesh::UpdateVertexRange(void* _dataPointer, size_t _dataStructureSize, unsigned _firstVertex, unsigned _vertexCount)
+	{
+
+		PE_GL(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+		PE_GL(glBufferSubData(GL_ARRAY_BUFFER, _dataStructureSize * _firstVertex, _dataStructureSize * _vertexCount, _dataPointer));
+
+	}
+
+	void Mesh::UpdateIndices(const std::vector<unsigned int>& _indices)
+	{
+
+		indexCount = _indices.size();
+
+		// The Element Buffer binding is part of the VAO.
+		PE_GL(glBindVertexArray(VAO));
+		PE_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
+		PE_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * _indices.size(), _indices.empty() ? nullptr : &_indices[0], GL_DYNAMIC_DRAW));
+		PE_GL(glBindVertexArray(0));
+
+	}
 }
@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <vector>
+#include <cstddef>
 #include <glad/glad.h>
 #include <memory>
 
@@ -99,6 +100,12 @@ namespace pilot
 		// Use this to update the vertex data.. once in a while. Not alywas as this is expensive.
 		void UpdateVertices(void* _dataPointer, size_t _dataStructureSize, unsigned _vertexCount);
 
+		// Update only some of the vertices, in place. _dataPointer points at the first one to update. The buffer keeps its size.
+		void UpdateVertexRange(void* _dataPointer, size_t _dataStructureSize, unsigned _firstVertex, unsigned _vertexCount);
+
+		// Replace the indices, e.g, to draw a different set of the triangles. The Mesh has to be created with indices.
+		void UpdateIndices(const std::vector<unsigned int>& _indices);
+
 		void Render(const std::string& _shaderName);
 	};
 
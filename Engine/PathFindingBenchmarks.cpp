@@ -0,0 +1,348 @@
+#if DEBUG
+
+// These build Terrains without a Mesh, so they need no Window or GL Context, and do not use the AllTests Fixture.
+// They are Disabled, so that they only run when asked for, with --gtest_also_run_disabled_tests and a --gtest_filter.
+
+#include <gtest/gtest.h>
+#include "FolderLocations.h"
+#include "Terrain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <random>
+
+/**
+ * \brief Runs a fixed set of random queries on a square Terrain and logs the Node Expansions per second.
+ * \param _nodeCount Number of Nodes along each side of the Terrain.
+ * \param _queryCount Number of Path Queries to run.
+ */
+static void RunPathFindingBenchmark(unsigned int _nodeCount, unsigned int _queryCount)
+{
+	// A Grid Length of 1 gives us ( length + 1 ) nodes along each side.
+	pilot::Terrain terrain(_nodeCount - 1, _nodeCount - 1, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+
+	ASSERT_EQ(_nodeCount, terrain.GetNodeCountX());
+	ASSERT_EQ(_nodeCount, terrain.GetNodeCountZ());
+
+	// Run the same queries with plain A* and with Jump Point Search, so we can compare the Expansions.
+	for (const bool jump_point_search : { false, true })
+	{
+		terrain.SetJumpPointSearch(jump_point_search);
+
+		// Seeded, so that every run uses the same queries.
+		std::mt19937 generator(1234);
+		std::uniform_int_distribution<int> distribution(0, _nodeCount - 1);
+
+		unsigned long long total_expansions = 0;
+		unsigned int paths_found = 0;
+
+		const auto start_time = std::chrono::high_resolution_clock::now();
+
+		for (unsigned int i = 0; i < _queryCount; i++)
+		{
+			pilot::MapTile * start_tile = terrain.GetTileFromIndices(distribution(generator), distribution(generator));
+			pilot::MapTile * end_tile = terrain.GetTileFromIndices(distribution(generator), distribution(generator));
+
+			if (!terrain.GetPathFromTiles(start_tile, end_tile).empty())
+			{
+				paths_found++;
+			}
+
+			total_expansions += terrain.GetLastPathExpansions();
+		}
+
+		const auto end_time = std::chrono::high_resolution_clock::now();
+		const double seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+		std::cout << "[PathFinding] " << (jump_point_search ? "JPS " : "A* ") << _nodeCount << "x" << _nodeCount << ": " << _queryCount << " queries, "
+			<< paths_found << " paths found, " << total_expansions << " expansions in " << seconds << "s ( "
+			<< (seconds > 0.0 ? total_expansions / seconds : 0.0) << " expansions/s )" << std::endl;
+
+		EXPECT_GT(total_expansions, 0u);
+	}
+}
+
+/**
+ * \brief Runs the same random queries with the flat Search and the Hierarchical one ( fully refined ), and logs the time taken by each.
+ * \param _nodeCount Number of Nodes along each side of the Terrain.
+ * \param _queryCount Number of Path Queries to run.
+ */
+static void RunHierarchicalPathFindingBenchmark(unsigned int _nodeCount, unsigned int _queryCount)
+{
+	pilot::Terrain terrain(_nodeCount - 1, _nodeCount - 1, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+
+	std::mt19937 generator(1234);
+	std::uniform_int_distribution<int> distribution(0, _nodeCount - 1);
+
+	// Scatter some Obstacles, so that the Paths are not just straight lines.
+	for (unsigned int i = 0; i < _nodeCount * _nodeCount / 20; i++)
+	{
+		terrain.SetTerrainNodeObstacle(glm::ivec2(distribution(generator), distribution(generator)));
+	}
+
+	// The first Query rebuilds the Clusters the Obstacles landed in. Keep that out of the timing.
+	const auto rebuild_start_time = std::chrono::high_resolution_clock::now();
+	terrain.GetHierarchicalPath(glm::vec3(0.0f), glm::vec3(0.0f));
+	const double rebuild_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - rebuild_start_time).count();
+
+	std::vector<std::pair<pilot::MapTile *, pilot::MapTile *>> queries;
+	for (unsigned int i = 0; i < _queryCount; i++)
+	{
+		queries.emplace_back(
+			terrain.GetTileFromIndices(distribution(generator), distribution(generator)),
+			terrain.GetTileFromIndices(distribution(generator), distribution(generator))
+		);
+	}
+
+	unsigned int flat_paths_found = 0;
+	auto start_time = std::chrono::high_resolution_clock::now();
+
+	for (const auto& query : queries)
+	{
+		flat_paths_found += !terrain.GetPathFromTiles(query.first, query.second).empty();
+	}
+
+	const double flat_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+	unsigned int hierarchical_paths_found = 0;
+	start_time = std::chrono::high_resolution_clock::now();
+
+	for (const auto& query : queries)
+	{
+		auto path = terrain.GetHierarchicalPath(terrain.GetTilePosition(query.first), terrain.GetTilePosition(query.second));
+		terrain.RefineHierarchicalPath(path, static_cast<unsigned int>(path.waypoints.size()));
+		hierarchical_paths_found += !path.tiles.empty();
+	}
+
+	const double hierarchical_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+	std::cout << "[PathFinding] " << _nodeCount << "x" << _nodeCount << ": " << _queryCount << " queries, flat "
+		<< flat_seconds << "s ( " << flat_paths_found << " found ), hierarchical " << hierarchical_seconds << "s ( "
+		<< hierarchical_paths_found << " found ), " << terrain.GetHierarchicalPathFinder().GetAbstractNodeCount()
+		<< " abstract nodes, cluster rebuild " << rebuild_seconds << "s" << std::endl;
+
+	EXPECT_EQ(flat_paths_found, hierarchical_paths_found);
+}
+
+/**
+ * \brief Runs the same random queries with each Heuristic, and logs the Expansions and the total Cost of the Paths found.
+ * \param _nodeCount Number of Nodes along each side of the Terrain.
+ * \param _queryCount Number of Path Queries to run.
+ */
+static void RunHeuristicBenchmark(unsigned int _nodeCount, unsigned int _queryCount)
+{
+	pilot::Terrain terrain(_nodeCount - 1, _nodeCount - 1, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+
+	std::mt19937 generator(1234);
+	std::uniform_int_distribution<int> distribution(0, _nodeCount - 1);
+
+	std::vector<std::pair<pilot::MapTile *, pilot::MapTile *>> queries;
+	for (unsigned int i = 0; i < _queryCount; i++)
+	{
+		queries.emplace_back(
+			terrain.GetTileFromIndices(distribution(generator), distribution(generator)),
+			terrain.GetTileFromIndices(distribution(generator), distribution(generator))
+		);
+	}
+
+	const char * names[] = { "Manhattan", "Octile", "Landmarks" };
+	unsigned long long expansions[3] = {};
+	double costs[3] = {};
+
+	for (auto heuristic = 0; heuristic < 3; heuristic++)
+	{
+		const auto start_time = std::chrono::high_resolution_clock::now();
+		terrain.SetPathHeuristic(pilot::PathHeuristic(heuristic));
+		const double build_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+		const auto query_start_time = std::chrono::high_resolution_clock::now();
+
+		for (const auto& query : queries)
+		{
+			const auto path = terrain.GetPathFromTiles(query.first, query.second);
+			expansions[heuristic] += terrain.GetLastPathExpansions();
+
+			// Stepping off a Tile costs its navCost. The Path is stored from the End, so walk it backwards.
+			const pilot::MapTile * current = query.first;
+			for (auto it = path.rbegin(); it != path.rend(); ++it)
+			{
+				costs[heuristic] += terrain.GetNavCost(current);
+				current = *it;
+			}
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - query_start_time).count();
+
+		std::cout << "[PathFinding] " << names[heuristic] << " " << _nodeCount << "x" << _nodeCount << ": " << _queryCount << " queries, "
+			<< expansions[heuristic] << " expansions in " << seconds << "s, total path cost " << costs[heuristic]
+			<< ", heuristic set up in " << build_seconds << "s" << std::endl;
+	}
+
+	// Both the admissible Heuristics find the cheapest Paths. The Landmarks only make them look at fewer Tiles.
+	EXPECT_NEAR(costs[pilot::PE_HEURISTIC_OCTILE], costs[pilot::PE_HEURISTIC_LANDMARKS], 0.01 * _queryCount);
+	EXPECT_LE(costs[pilot::PE_HEURISTIC_OCTILE], costs[pilot::PE_HEURISTIC_MANHATTAN] + 0.01 * _queryCount);
+	EXPECT_LT(expansions[pilot::PE_HEURISTIC_LANDMARKS], expansions[pilot::PE_HEURISTIC_OCTILE]);
+}
+
+/**
+ * \brief Runs a seeded set of random queries through GetPathFromTiles, and writes one line of JSON with the results.
+ *
+ * The line goes to the Console, and is appended to the Results File if there is one, so that runs can be compared by a script.
+ * \param _mapName Name of the Map, for the Results.
+ * \param _terrain The Terrain to search on. Create it without a Mesh, so that this runs without a GL Context.
+ * \param _buildSeconds How long it took to create the Terrain.
+ * \param _queryCount Number of Path Queries to run.
+ * \param _resultsPath The File to append the Results to. Empty to only write them to the Console.
+ */
+static void RunPathFindingSuiteMap(const std::string& _mapName, pilot::Terrain& _terrain, double _buildSeconds, unsigned int _queryCount, const std::string& _resultsPath)
+{
+	std::mt19937 generator(4321);
+	std::uniform_int_distribution<int> distribution_x(0, _terrain.GetNodeCountX() - 1);
+	std::uniform_int_distribution<int> distribution_z(0, _terrain.GetNodeCountZ() - 1);
+
+	std::vector<std::pair<pilot::MapTile *, pilot::MapTile *>> queries;
+	for (unsigned int i = 0; i < _queryCount; i++)
+	{
+		queries.emplace_back(
+			_terrain.GetTileFromIndices(distribution_x(generator), distribution_z(generator)),
+			_terrain.GetTileFromIndices(distribution_x(generator), distribution_z(generator))
+		);
+	}
+
+	std::vector<double> latencies;
+	latencies.reserve(_queryCount);
+
+	unsigned long long total_expansions = 0;
+	unsigned int paths_found = 0;
+
+	for (const auto& query : queries)
+	{
+		const auto start_time = std::chrono::high_resolution_clock::now();
+		paths_found += !_terrain.GetPathFromTiles(query.first, query.second).empty();
+		latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count());
+
+		total_expansions += _terrain.GetLastPathExpansions();
+	}
+
+	double total_milliseconds = 0.0;
+	for (const auto latency : latencies)
+	{
+		total_milliseconds += latency;
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	const auto percentile = [&latencies](double _fraction)
+	{
+		return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, size_t(_fraction * latencies.size()))];
+	};
+
+	std::ostringstream result;
+	result << "{\"map\":\"" << _mapName << "\",\"nodes_x\":" << _terrain.GetNodeCountX() << ",\"nodes_z\":" << _terrain.GetNodeCountZ()
+		<< ",\"queries\":" << _queryCount << ",\"paths_found\":" << paths_found
+		<< ",\"queries_per_second\":" << (total_milliseconds > 0.0 ? 1000.0 * _queryCount / total_milliseconds : 0.0)
+		<< ",\"nodes_expanded\":" << total_expansions << ",\"nodes_expanded_per_query\":" << (_queryCount > 0 ? double(total_expansions) / _queryCount : 0.0)
+		<< ",\"p50_ms\":" << percentile(0.5) << ",\"p99_ms\":" << percentile(0.99) << ",\"build_ms\":" << _buildSeconds * 1000.0 << "}";
+
+	std::cout << "[PathFinding] " << result.str() << std::endl;
+
+	if (!_resultsPath.empty())
+	{
+		std::ofstream results_file(_resultsPath, std::ios::app);
+		results_file << result.str() << std::endl;
+	}
+
+	EXPECT_EQ(_queryCount, latencies.size());
+}
+
+/**
+ * \brief Runs the Suite on the Height Maps we ship, and on generated Maps, at a few sizes. Needs no GL Context.
+ * \param _queryCount Number of Path Queries to run on each Map.
+ * \param _resultsPath The File to append the Results to. Empty to only write them to the Console.
+ */
+static void RunPathFindingSuite(unsigned int _queryCount, const std::string& _resultsPath)
+{
+	const float pi = 3.14159265f;
+
+	const std::vector<std::pair<std::string, std::function<float(float, float)>>> generated_maps = {
+		{ "flat", [](float, float) { return 0.0f; } },
+		{ "hills", [pi](float _x, float _z) { return 0.5f + 0.25f * std::sin(_x * 8.0f * pi) * std::cos(_z * 8.0f * pi); } },
+		{ "ridges", [pi](float _x, float _z) { return std::abs(std::sin((_x + 0.5f * _z) * 24.0f * pi)); } }
+	};
+
+	for (const unsigned int node_count : { 128u, 256u, 512u, 1024u })
+	{
+		for (const std::string height_map : { "heightmap.jpg", "heightmap-divided.jpg" })
+		{
+			const auto start_time = std::chrono::high_resolution_clock::now();
+			pilot::Terrain terrain(node_count - 1, node_count - 1, 1, 1, TEXTURE_FOLDER + height_map, false);
+			const double build_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+			RunPathFindingSuiteMap(height_map, terrain, build_seconds, _queryCount, _resultsPath);
+		}
+
+		for (const auto& generated_map : generated_maps)
+		{
+			const auto start_time = std::chrono::high_resolution_clock::now();
+			pilot::Terrain terrain(node_count - 1, node_count - 1, 1, 1, generated_map.second, false);
+			const double build_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+			RunPathFindingSuiteMap(generated_map.first, terrain, build_seconds, _queryCount, _resultsPath);
+		}
+
+		// A flat Map with a seeded scatter of Obstacles, so that the Searches have to go around things.
+		{
+			const auto start_time = std::chrono::high_resolution_clock::now();
+			pilot::Terrain terrain(node_count - 1, node_count - 1, 1, 1, generated_maps[0].second, false);
+
+			std::mt19937 generator(1234);
+			std::uniform_int_distribution<int> distribution(0, node_count - 1);
+
+			for (unsigned int i = 0; i < node_count * node_count / 5; i++)
+			{
+				terrain.SetTerrainNodeObstacle(glm::ivec2(distribution(generator), distribution(generator)));
+			}
+
+			const double build_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+			RunPathFindingSuiteMap("obstacles", terrain, build_seconds, _queryCount, _resultsPath);
+		}
+	}
+}
+
+TEST(PathFindingBenchmarks, DISABLED_PathFinding256)
+{
+	RunPathFindingBenchmark(256, 200);
+}
+
+TEST(PathFindingBenchmarks, DISABLED_PathFinding1024)
+{
+	RunPathFindingBenchmark(1024, 50);
+}
+
+TEST(PathFindingBenchmarks, DISABLED_Heuristics256)
+{
+	RunHeuristicBenchmark(256, 100);
+}
+
+TEST(PathFindingBenchmarks, DISABLED_HierarchicalPathFinding1024)
+{
+	RunHierarchicalPathFindingBenchmark(1024, 50);
+}
+
+// Set PATHFINDING_RESULTS to a File Path to append the Results to it as JSON Lines.
+TEST(PathFindingBenchmarks, DISABLED_Suite)
+{
+	const char * results_path = std::getenv("PATHFINDING_RESULTS");
+	RunPathFindingSuite(100, nullptr != results_path ? results_path : "");
+}
+
+#endif
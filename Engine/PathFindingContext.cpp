@@ -0,0 +1,136 @@
+#include "PathFindingContext.h"
+
+#include <climits>
+
+namespace pilot {
+
+	void PathFindingContext::PlaceInHeap(int _tileIndex, int _heapIndex)
+	{
+		openSet[_heapIndex] = _tileIndex;
+		nodes[_tileIndex].heapIndex = _heapIndex;
+	}
+
+	void PathFindingContext::SiftUp(int _heapIndex)
+	{
+		const int tile_index = openSet[_heapIndex];
+		const float f_cost = nodes[tile_index].fCost;
+
+		while (_heapIndex > 0)
+		{
+			const int parent_index = (_heapIndex - 1) / 2;
+
+			if (nodes[openSet[parent_index]].fCost <= f_cost)
+			{
+				break;
+			}
+
+			PlaceInHeap(openSet[parent_index], _heapIndex);
+			_heapIndex = parent_index;
+		}
+
+		PlaceInHeap(tile_index, _heapIndex);
+	}
+
+	void PathFindingContext::SiftDown(int _heapIndex)
+	{
+		const int tile_index = openSet[_heapIndex];
+		const float f_cost = nodes[tile_index].fCost;
+		const int count = int(openSet.size());
+
+		while (true)
+		{
+			int child_index = 2 * _heapIndex + 1;
+
+			if (child_index >= count)
+			{
+				break;
+			}
+
+			// Pick the lesser of the two children.
+			if (child_index + 1 < count && nodes[openSet[child_index + 1]].fCost < nodes[openSet[child_index]].fCost)
+			{
+				child_index++;
+			}
+
+			if (f_cost <= nodes[openSet[child_index]].fCost)
+			{
+				break;
+			}
+
+			PlaceInHeap(openSet[child_index], _heapIndex);
+			_heapIndex = child_index;
+		}
+
+		PlaceInHeap(tile_index, _heapIndex);
+	}
+
+	void PathFindingContext::BeginSearch(size_t _tileCount)
+	{
+		if (nodes.size() != _tileCount)
+		{
+			nodes.assign(_tileCount, SearchNode());
+			searchGeneration = 0;
+		}
+
+		searchGeneration++;
+
+		// When the counter wraps around, stale stamps could match again. Clear them all, once every 4 billion searches.
+		if (0 == searchGeneration)
+		{
+			for (auto& node : nodes)
+			{
+				node.searchId = 0;
+			}
+
+			searchGeneration = 1;
+		}
+
+		openSet.clear();
+		lastExpansions = 0;
+	}
+
+	SearchNode& PathFindingContext::GetNode(int _tileIndex)
+	{
+		SearchNode& node = nodes[_tileIndex];
+
+		if (node.searchId != searchGeneration)
+		{
+			node.gCost = node.fCost = INT_MAX;
+			node.parent = -1;
+			node.heapIndex = -1;
+			node.open = false;
+			node.closed = false;
+			node.searchId = searchGeneration;
+		}
+
+		return node;
+	}
+
+	void PathFindingContext::PushOpen(int _tileIndex)
+	{
+		openSet.push_back(_tileIndex);
+		SiftUp(int(openSet.size()) - 1);
+	}
+
+	int PathFindingContext::PopOpen()
+	{
+		const int top = openSet[0];
+		const int last = openSet.back();
+		openSet.pop_back();
+
+		if (!openSet.empty())
+		{
+			PlaceInHeap(last, 0);
+			SiftDown(0);
+		}
+
+		nodes[top].heapIndex = -1;
+		return top;
+	}
+
+	void PathFindingContext::DecreaseKey(int _tileIndex)
+	{
+		SiftUp(nodes[_tileIndex].heapIndex);
+	}
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+namespace pilot {
+
+	/**
+	 * \brief Where a Path Query that can be carried on, is at.
+	 */
+	enum PathSearchStatus
+	{
+		PE_SEARCH_IN_PROGRESS,
+		PE_SEARCH_FOUND,
+		PE_SEARCH_NOT_FOUND
+	};
+
+	/**
+	 * \brief The A* bookkeeping for a single Tile, during a single Search.
+	 */
+	struct SearchNode
+	{
+		float gCost = 0.0f;
+		float fCost = 0.0f;
+
+		/**
+		 * \brief Index of the Tile we arrived at this Tile from. -1 for the Start Tile.
+		 */
+		int parent = -1;
+
+		/**
+		 * \brief Where this Tile is in the Open Set Heap. -1 if it is not in the Heap.
+		 */
+		int heapIndex = -1;
+
+		/**
+		 * \brief The Search that last touched this Node. If it is not the current Search, the Node counts as reset.
+		 */
+		unsigned int searchId = 0;
+
+		bool open = false;
+		bool closed = false;
+	};
+
+	/**
+	 * \brief All the scratch state a Path Query needs, kept out of the shared Map Tiles.
+	 *
+	 * Every thread that runs Path Queries should own one of these, and can reuse it for as many queries as it wants.
+	 * The Open Set is an Indexed Binary Min Heap of Tile Indices, keyed on the F Cost of their Search Node.
+	 */
+	class PathFindingContext
+	{
+
+		std::vector<SearchNode> nodes;
+
+		std::vector<int> openSet;
+
+		/**
+		 * \brief Incremented for every Search. Nodes with a different searchId are stale.
+		 */
+		unsigned int searchGeneration = 0;
+
+		/**
+		 * \brief Number of Nodes expanded by the last Search that used this Context.
+		 */
+		unsigned int lastExpansions = 0;
+
+		/**
+		 * \brief The Start and End Tiles of the current Search, so that it can be carried on later.
+		 */
+		int searchStartIndex = -1;
+		int searchEndIndex = -1;
+
+		void PlaceInHeap(int _tileIndex, int _heapIndex);
+
+		void SiftUp(int _heapIndex);
+
+		void SiftDown(int _heapIndex);
+
+	public:
+
+		PathFindingContext() = default;
+
+		unsigned int GetLastExpansions() const
+		{
+			return lastExpansions;
+		}
+
+		int GetSearchStartIndex() const
+		{
+			return searchStartIndex;
+		}
+
+		int GetSearchEndIndex() const
+		{
+			return searchEndIndex;
+		}
+
+		void SetSearchEnds(int _startIndex, int _endIndex)
+		{
+			searchStartIndex = _startIndex;
+			searchEndIndex = _endIndex;
+		}
+
+		/**
+		 * \brief Start a new Search over a Grid of _tileCount Tiles. All the Nodes count as reset after this.
+		 * \param _tileCount The Number of Tiles in the Grid being searched.
+		 */
+		void BeginSearch(size_t _tileCount);
+
+		/**
+		 * \brief Get the Search Node of a Tile, resetting it first if it is stale.
+		 * \param _tileIndex The Index of the Tile.
+		 * \return The Search Node of the Tile, for the current Search.
+		 */
+		SearchNode& GetNode(int _tileIndex);
+
+		/**
+		 * \brief Count one more Node expansion for the current Search.
+		 */
+		void CountExpansion()
+		{
+			lastExpansions++;
+		}
+
+		bool IsOpenSetEmpty() const
+		{
+			return openSet.empty();
+		}
+
+		/**
+		 * \brief Add the Tile to the Open Set. Its Node should be up to date and not already be in the Open Set.
+		 * \param _tileIndex The Index of the Tile.
+		 */
+		void PushOpen(int _tileIndex);
+
+		/**
+		 * \brief Remove the Tile with the least F Cost from the Open Set.
+		 * \return Index of the Tile with the least F Cost.
+		 */
+		int PopOpen();
+
+		/**
+		 * \brief Restore the Heap order after the F Cost of a Tile in the Open Set was lowered.
+		 * \param _tileIndex The Index of the Tile.
+		 */
+		void DecreaseKey(int _tileIndex);
+
+	};
+
+}
@@ -0,0 +1,181 @@
+#include "PathScheduler.h"
+#include "Terrain.h"
+
+#include <algorithm>
+
+namespace pilot {
+
+	PathScheduler::PathScheduler(unsigned int _maxActiveSearches)
+		: contexts(std::max(_maxActiveSearches, 1u)), contextOwners(std::max(_maxActiveSearches, 1u), nullptr)
+	{
+	}
+
+	void PathScheduler::ReleaseContext(PathTicket& _ticket)
+	{
+		if (_ticket.contextIndex >= 0)
+		{
+			contextOwners[_ticket.contextIndex] = nullptr;
+			_ticket.contextIndex = -1;
+		}
+	}
+
+	int PathScheduler::AcquireContext(PathTicket& _ticket)
+	{
+		for (auto i = 0; i < int(contextOwners.size()); i++)
+		{
+			if (nullptr == contextOwners[i])
+			{
+				contextOwners[i] = &_ticket;
+				return i;
+			}
+		}
+
+		// The Queue is sorted, so this is the least important Search in progress. It starts over when its turn comes again.
+		for (auto it = queue.rbegin(); it != queue.rend(); ++it)
+		{
+			if ((*it)->contextIndex >= 0 && it->get() != &_ticket)
+			{
+				const int context_index = (*it)->contextIndex;
+				(*it)->contextIndex = -1;
+				contextOwners[context_index] = &_ticket;
+				return context_index;
+			}
+		}
+
+		return -1;
+	}
+
+	void PathScheduler::Request(const std::shared_ptr<PathTicket>& _ticket, const MapTile * _startTile, const MapTile * _endTile, PathPriority _priority)
+	{
+		ReleaseContext(*_ticket);
+
+		_ticket->startTile = _startTile;
+		_ticket->endTile = _endTile;
+		_ticket->priority = _priority;
+		_ticket->requestOrder = requestCounter++;
+
+		if (!_ticket->pending)
+		{
+			_ticket->pending = true;
+			queue.push_back(_ticket);
+		}
+	}
+
+	std::shared_ptr<PathTicket> PathScheduler::Request(const MapTile * _startTile, const MapTile * _endTile, PathPriority _priority)
+	{
+		auto ticket = std::make_shared<PathTicket>();
+		Request(ticket, _startTile, _endTile, _priority);
+		return ticket;
+	}
+
+	void PathScheduler::Cancel(PathTicket& _ticket)
+	{
+		if (!_ticket.pending)
+		{
+			return;
+		}
+
+		ReleaseContext(_ticket);
+		_ticket.pending = false;
+
+		queue.erase(
+			std::remove_if(queue.begin(), queue.end(), [&_ticket](const std::shared_ptr<PathTicket>& _queued) { return _queued.get() == &_ticket; }),
+			queue.end()
+		);
+	}
+
+	void PathScheduler::Update(const Terrain& _terrain, unsigned int _expansionBudget)
+	{
+		lastExpansions = 0;
+
+		// Forget the Requests nobody is waiting for anymore.
+		for (auto& ticket : queue)
+		{
+			if (ticket.use_count() == 1)
+			{
+				ReleaseContext(*ticket);
+				ticket->pending = false;
+			}
+		}
+
+		queue.erase(
+			std::remove_if(queue.begin(), queue.end(), [](const std::shared_ptr<PathTicket>& _ticket) { return !_ticket->pending; }),
+			queue.end()
+		);
+
+		std::stable_sort(queue.begin(), queue.end(), [](const std::shared_ptr<PathTicket>& _a, const std::shared_ptr<PathTicket>& _b)
+		{
+			if (_a->priority != _b->priority)
+			{
+				return _a->priority > _b->priority;
+			}
+
+			return _a->requestOrder < _b->requestOrder;
+		});
+
+		size_t done_count = 0;
+
+		for (auto& ticket : queue)
+		{
+			if (lastExpansions >= _expansionBudget)
+			{
+				break;
+			}
+
+			// Obstacles placed since the Search started could be in the middle of what it found so far.
+			if (ticket->contextIndex >= 0 && ticket->obstacleVersion != _terrain.GetObstacleVersion())
+			{
+				ReleaseContext(*ticket);
+			}
+
+			std::vector<MapTile *> path;
+			PathSearchStatus status;
+
+			if (ticket->contextIndex < 0)
+			{
+				ticket->contextIndex = AcquireContext(*ticket);
+				ticket->obstacleVersion = _terrain.GetObstacleVersion();
+
+				if (!_terrain.BeginPathSearch(ticket->startTile, ticket->endTile, contexts[ticket->contextIndex]))
+				{
+					status = PE_SEARCH_NOT_FOUND;
+				}
+				else
+				{
+					status = PE_SEARCH_IN_PROGRESS;
+				}
+			}
+			else
+			{
+				status = PE_SEARCH_IN_PROGRESS;
+			}
+
+			if (PE_SEARCH_IN_PROGRESS == status)
+			{
+				PathFindingContext& context = contexts[ticket->contextIndex];
+				const unsigned int expansions_before = context.GetLastExpansions();
+
+				status = _terrain.ContinuePathSearch(context, _expansionBudget - lastExpansions, path);
+
+				lastExpansions += context.GetLastExpansions() - expansions_before;
+			}
+
+			if (PE_SEARCH_IN_PROGRESS != status)
+			{
+				ReleaseContext(*ticket);
+				ticket->path = std::move(path);
+				ticket->pending = false;
+				done_count++;
+			}
+		}
+
+		if (done_count > 0)
+		{
+			queue.erase(
+				std::remove_if(queue.begin(), queue.end(), [](const std::shared_ptr<PathTicket>& _ticket) { return !_ticket->pending; }),
+				queue.end()
+			);
+		}
+	}
+
+}
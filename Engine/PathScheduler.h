@@ -0,0 +1,161 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <memory>
+#include "PathFindingContext.h"
+
+namespace pilot {
+
+	class Terrain;
+	class MapTile;
+
+	/**
+	 * \brief Which Path Requests the Scheduler serves first.
+	 */
+	enum PathPriority
+	{
+		PE_PATH_PRIORITY_LOW,
+		PE_PATH_PRIORITY_NORMAL,
+		PE_PATH_PRIORITY_HIGH
+	};
+
+	/**
+	 * \brief The Handle to a Path Request. Keep it around, and read the Path once it is no longer pending.
+	 *
+	 * A Ticket can be requested again. It keeps the last Path it found till the new one is done, so a unit can keep walking meanwhile.
+	 */
+	class PathTicket
+	{
+
+		friend class PathScheduler;
+
+		const MapTile * startTile = nullptr;
+		const MapTile * endTile = nullptr;
+
+		PathPriority priority = PE_PATH_PRIORITY_NORMAL;
+
+		/**
+		 * \brief When it was requested. Requests with the same Priority are served in order.
+		 */
+		unsigned long long requestOrder = 0;
+
+		/**
+		 * \brief The Scheduler's Context the Search is in. -1 if the Search has not started yet.
+		 */
+		int contextIndex = -1;
+
+		/**
+		 * \brief The Obstacle Version of the Terrain, when the Search started. If it changed, the Search starts over.
+		 */
+		unsigned int obstacleVersion = 0;
+
+		bool pending = false;
+
+		std::vector<MapTile *> path;
+
+	public:
+
+		PathTicket() = default;
+
+		bool IsPending() const
+		{
+			return pending;
+		}
+
+		PathPriority GetPriority() const
+		{
+			return priority;
+		}
+
+		/**
+		 * \brief The last Path found for this Ticket. The first step is at the back. Empty if there was no Path.
+		 */
+		const std::vector<MapTile *>& GetPath() const
+		{
+			return path;
+		}
+
+	};
+
+	/**
+	 * \brief Runs Path Requests a little at a time, so that a long Search never takes more than its share of a frame.
+	 *
+	 * Every Update expands at most the given number of Nodes over all the Requests, the higher Priority ones first. A Search that
+	 * runs out of budget carries on from where it was in the next Update. Requests whose Tickets nobody holds anymore are dropped.
+	 */
+	class PathScheduler
+	{
+
+		/**
+		 * \brief One per Search that can be in progress at the same time.
+		 */
+		std::vector<PathFindingContext> contexts;
+
+		/**
+		 * \brief The Ticket using each Context. nullptr if it is free.
+		 */
+		std::vector<PathTicket *> contextOwners;
+
+		std::vector<std::shared_ptr<PathTicket>> queue;
+
+		unsigned long long requestCounter = 0;
+
+		unsigned int lastExpansions = 0;
+
+		void ReleaseContext(PathTicket& _ticket);
+
+		/**
+		 * \brief Get a Context for the Ticket. If they are all in use, take it from the last Ticket in the Queue that has one.
+		 */
+		int AcquireContext(PathTicket& _ticket);
+
+	public:
+
+		/**
+		 * \brief Create the Scheduler.
+		 * \param _maxActiveSearches How many Searches can be in progress at the same time. Each one holds a Context as big as the Terrain.
+		 */
+		explicit PathScheduler(unsigned int _maxActiveSearches = 4);
+
+		/**
+		 * \brief Ask for a Path. If the Ticket is already pending, its Search starts over with the new Tiles and Priority.
+		 * \param _ticket The Ticket to get the Path in.
+		 * \param _startTile The Start Tile
+		 * \param _endTile The End Tile
+		 * \param _priority Higher Priority Requests are served first.
+		 */
+		void Request(const std::shared_ptr<PathTicket>& _ticket, const MapTile * _startTile, const MapTile * _endTile, PathPriority _priority);
+
+		/**
+		 * \brief Ask for a Path, with a new Ticket.
+		 */
+		std::shared_ptr<PathTicket> Request(const MapTile * _startTile, const MapTile * _endTile, PathPriority _priority);
+
+		/**
+		 * \brief Stop looking for a Path for the Ticket. It keeps its last Path.
+		 */
+		void Cancel(PathTicket& _ticket);
+
+		/**
+		 * \brief Carry on the Searches, the higher Priority ones first.
+		 * \param _terrain The Terrain the Tiles belong to.
+		 * \param _expansionBudget How many Nodes we can expand in total, in this Update.
+		 */
+		void Update(const Terrain& _terrain, unsigned int _expansionBudget);
+
+		size_t GetPendingCount() const
+		{
+			return queue.size();
+		}
+
+		/**
+		 * \brief Number of Nodes expanded in the last Update.
+		 */
+		unsigned int GetLastExpansions() const
+		{
+			return lastExpansions;
+		}
+
+	};
+
+}
@@ -28,9 +28,8 @@ namespace pe_helpers {
 		// Read Data to this var.
 		_in.read((char*)temp_char_string, string_length);
 
-		(_output) = temp_char_string;
-
-		_output.resize(string_length);
+		// It is not Null Terminated in the File, so copy exactly that many.
+		(_output).assign(temp_char_string, string_length);
 
 		delete[] temp_char_string;
 
@@ -3,8 +3,7 @@
 #version 430 core
 layout(location = 0) in vec4 aPos;
 layout(location = 1) in vec4 aNormal;
-layout(location = 2) in vec4 aColour;
-layout(location = 3) in vec4 aTexCoords;
+layout(location = 2) in vec4 aTexCoords;
 
 struct vData {
 	vec3 g_FragPos;
@@ -17,13 +16,19 @@ out vData g_Stuff;
 
 uniform mat4 u_ModelMatrix;
 
+// The Tile States. A Texel for each Vertex, in the same order. RGB is the Colour, and A is how much of it to mix in.
+uniform sampler2D u_Texture1;
+
 void main()
 {
 
+	ivec2 state_size = textureSize(u_Texture1, 0);
+	vec4 tile_state = texelFetch(u_Texture1, ivec2(gl_VertexID % state_size.x, gl_VertexID / state_size.x), 0);
+
 	g_Stuff.g_FragPos = vec3(u_ModelMatrix * vec4(aPos.xyz, 1.0));
 	g_Stuff.g_Normal = mat3(transpose(inverse(u_ModelMatrix))) * aNormal.xyz;
-	g_Stuff.g_TexCoords = aTexCoords.xyz;
-	g_Stuff.g_Colour = aColour.xyz;
+	g_Stuff.g_TexCoords = vec3(aTexCoords.xy, tile_state.a);
+	g_Stuff.g_Colour = tile_state.rgb;
 
 	gl_Position = u_ModelMatrix * vec4(aPos.xyz, 1.0);
 
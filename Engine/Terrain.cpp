@@ -3,71 +3,156 @@
 #include "Colours.h"
 #include "LoggingManager.h"
 #include "AssetManager.h"
+#include "Texture.h"
 #include "Ray.h"
+#include "WorkerPool.h"
 
 #include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <deque>
+#include <queue>
+#include <functional>
+#include <unordered_map>
 #include "SaveSceneHelpers.h"
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define UNPASSABLE_NAV_COST_LIMIT		1.0f
+#define TERRAIN_PATCH_QUADS				16
+
+// Stop Jumps after this many Tiles. On open ground, every Diagonal step would otherwise scan out to the edge of the Terrain.
+#define MAX_JUMP_DISTANCE				8
+
+// Landmarks to build for the Incremental Planners, if nothing asked for them before.
+#define DEFAULT_LANDMARK_COUNT			8u
 
 namespace pilot {
 
-	glm::vec3 MapTile::GetPosition() const
+	const glm::ivec2 MapTile::navDirectionOffsets[8] = {
+		{ 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 },
+		{ -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }
+	};
+
+	bool MapTile::HasNeighbour(const MapTile * _tile) const
 	{
-		return glm::vec3(tilePosX, tilePosY, tilePosZ);
+		// The Direction for each ( X + 1, Z + 1 ) Offset.
+		static const signed char directions[3][3] = {
+			{ 5, 4, 3 },
+			{ 6, -1, 2 },
+			{ 7, 0, 1 }
+		};
+
+		const int dx = _tile->tileIndexX - tileIndexX;
+		const int dz = _tile->tileIndexZ - tileIndexZ;
+
+		if (dx < -1 || dx > 1 || dz < -1 || dz > 1)
+		{
+			return false;
+		}
+
+		const int direction = directions[dx + 1][dz + 1];
+		return direction >= 0 && CanStep(direction);
 	}
 
-	glm::vec3 Terrain::ComputeGridNormal(const int _x, const int _z)
+	void Terrain::ComputeNormals(glm::ivec2 _min, glm::ivec2 _max)
 	{
+		_min = glm::max(_min, glm::ivec2(0));
+		_max = glm::min(_max, glm::ivec2(nodeCountX - 1, nodeCountZ - 1));
 
-		if (_x > nodeCountX || _z > nodeCountZ || _x < 0 || _z < 0)
+		if (_min.x > _max.x || _min.y > _max.y)
 		{
-			LOGGER.AddToLog("Out of Bounds error when generating normals for Terrain", PE_LOG_ERROR);
+			return;
 		}
 
-		// If X and Z are the co ordinates. Get the Four surrounding Vertices it would be connected to.
+		const int count_z = _max.y - _min.y + 1;
+
+		// The Normal is ( -dH/dX, 1, -dH/dZ ), normalized. The Slopes are across the Neighbours on each side, or one sided on the Edges.
+		WORKERPOOL.ParallelFor(_max.x - _min.x + 1, [&](unsigned int _row, unsigned int)
+		{
+			const int i = _min.x + int(_row);
+			const int previous_x = glm::max(i - 1, 0);
+			const int next_x = glm::min(i + 1, int(nodeCountX) - 1);
 
-		/*		B
-		*		|
-		*C --- O ---- A
-		*		|
-		*		D
-		*
-		*		O is the current Vertex. A - D are the surrounding vertices. We compute the normals by computing the cross product for,
-		*		OA * OB
-		*		OB * OC
-		*		OC * OD
-		*		OD * OA
-		*
-		*		And averaging it.
-		*/
+			const float inverse_span_x = (next_x > previous_x) ? 1.0f / ((next_x - previous_x) * gridLength) : 0.0f;
+			const float inverse_span_z = 1.0f / (2.0f * gridBreadth);
 
-		glm::vec3 o_position = vertices[_x * nodeCountZ + _z].position;
+			// Pull the Heights out of the Vertices first, so that the loop below runs over plain floats.
+			std::vector<float> previous_row(count_z), next_row(count_z), row(count_z + 2);
 
-		glm::vec3 a_position = vertices[((_x + 1 < nodeCountX) ? _x + 1 : _x) * nodeCountZ + _z].position;
-		auto tester_temp = _x * nodeCountZ + (_z - 1 > nodeCountZ ? _z : _z - 1);
-		glm::vec3 b_position = vertices[_x * nodeCountZ + ((_z - 1 < 0) ? _z : _z - 1)].position;
-		glm::vec3 c_position = vertices[((_x - 1 < 0) ? _x : _x - 1) * nodeCountZ + _z].position;
-		glm::vec3 d_position = vertices[_x * nodeCountZ + ((_z + 1 < nodeCountZ) ? _z + 1 : _z)].position;
+			for (auto k = 0; k < count_z; k++)
+			{
+				const int j = _min.y + k;
+				previous_row[k] = vertices[previous_x * nodeCountZ + j].position.y;
+				next_row[k] = vertices[next_x * nodeCountZ + j].position.y;
+			}
 
-		glm::vec3 oa = a_position - o_position;
-		glm::vec3 ob = b_position - o_position;
-		glm::vec3 oc = c_position - o_position;
-		glm::vec3 od = d_position - o_position;
+			for (auto k = 0; k < count_z + 2; k++)
+			{
+				const int j = glm::clamp(_min.y + k - 1, 0, int(nodeCountZ) - 1);
+				row[k] = vertices[i * nodeCountZ + j].position.y;
+			}
 
-		glm::vec3 normal = glm::normalize(
-			glm::normalize(glm::cross(oa, ob)) +
-			glm::normalize(glm::cross(ob, oc)) +
-			glm::normalize(glm::cross(oc, od)) +
-			glm::normalize(glm::cross(od, oa))
-		);
+			std::vector<float> slopes_x(count_z), slopes_z(count_z);
+
+			for (auto k = 0; k < count_z; k++)
+			{
+				slopes_x[k] = (next_row[k] - previous_row[k]) * inverse_span_x;
+				slopes_z[k] = (row[k + 2] - row[k]) * inverse_span_z;
+			}
+
+			// The Edges only span one Node.
+			if (0 == _min.y && nodeCountZ > 1)
+			{
+				slopes_z[0] *= 2.0f;
+			}
+
+			if (int(nodeCountZ) - 1 == _max.y && nodeCountZ > 1)
+			{
+				slopes_z[count_z - 1] *= 2.0f;
+			}
+
+			for (auto k = 0; k < count_z; k++)
+			{
+				const float inverse_length = 1.0f / std::sqrt(slopes_x[k] * slopes_x[k] + slopes_z[k] * slopes_z[k] + 1.0f);
+				vertices[i * nodeCountZ + _min.y + k].normal = glm::vec4(-slopes_x[k] * inverse_length, inverse_length, -slopes_z[k] * inverse_length, 0.0f);
+			}
+		});
+	}
+
+	void Terrain::SetNodeHeight(int _x, int _z, float _height)
+	{
+		nodeHeights[_x * nodeCountZ + _z] = _height;
+
+		// Grow the Height Tree now, so that it never misses the new Height. It is made exact again in Update.
+		heightTree.Grow(_x, _z, _height);
 
-		return normal;
+		// The Nodes around it use it for their Normals.
+		const glm::ivec2 min(_x - 1, _z - 1);
+		const glm::ivec2 max(_x + 1, _z + 1);
+
+		dirtyHeightsMin = areHeightsDirty ? glm::min(dirtyHeightsMin, min) : min;
+		dirtyHeightsMax = areHeightsDirty ? glm::max(dirtyHeightsMax, max) : max;
+		areHeightsDirty = true;
+
+		if (!vertices.empty())
+		{
+			vertices[_x * nodeCountZ + _z].position.y = _height;
+		}
+	}
+
+	Terrain::Terrain(int _mapLength, int _mapBreadth, float _gridLength, float _gridBreadth, std::string _heightMapFile, bool _uploadMesh)
+		: length(_mapLength), breadth(_mapBreadth), gridLength(_gridLength), gridBreadth(_gridBreadth), heightMapFile(_heightMapFile), uploadMesh(_uploadMesh)
+	{
+
+		Init();
 
 	}
 
-	Terrain::Terrain(int _mapLength, int _mapBreadth, float _gridLength, float _gridBreadth, std::string _heightMapFile)
-		: length(_mapLength), breadth(_mapBreadth), gridLength(_gridLength), gridBreadth(_gridBreadth), heightMapFile(_heightMapFile)
+	Terrain::Terrain(int _mapLength, int _mapBreadth, float _gridLength, float _gridBreadth, std::function<float(float, float)> _heightFunction, bool _uploadMesh)
+		: length(_mapLength), breadth(_mapBreadth), gridLength(_gridLength), gridBreadth(_gridBreadth), heightFunction(std::move(_heightFunction)), uploadMesh(_uploadMesh)
 	{
 
 		Init();
@@ -75,71 +160,176 @@ namespace pilot {
 	}
 
 	void Terrain::Init()
+	{
+		CreateTiles();
+
+		// Load Stuff for PathFinding. Before the Vertices, which are coloured by whether we can walk on the Tiles.
+		InitPathFinding();
+
+		BuildMeshData();
+
+		if (uploadMesh)
+		{
+			UploadMesh();
+		}
+	}
+
+	/**
+	 * \brief Height of a Pixel of a Height Map, from 0 to 1. The Channels other than the Alpha are averaged, and Black is the highest.
+	 */
+	template <typename T>
+	static float GetPixelHeight(const T * _data, int _x, int _y, int _imageWidth, int _channels, float _maxValue)
+	{
+		const auto channels_without_alpha = (_channels == 2 || _channels == 4) ? (_channels - 1) : _channels;
+		const T * pixel = _data + (size_t(_y) * _imageWidth + _x) * _channels;
+
+		float total = 0;
+
+		for (auto it = 0; it < channels_without_alpha; it++)
+		{
+			total += pixel[it];
+		}
+
+		return 1.0f - total / (channels_without_alpha * _maxValue);
+	}
+
+	/**
+	 * \brief Bilinear Height of a Height Map, at ( _x, _y ) in Pixels.
+	 */
+	template <typename T>
+	static float SampleHeightMap(const T * _data, float _x, float _y, int _imageWidth, int _imageHeight, int _channels, float _maxValue)
+	{
+		const int x0 = glm::clamp(int(_x), 0, _imageWidth - 1);
+		const int y0 = glm::clamp(int(_y), 0, _imageHeight - 1);
+		const int x1 = glm::min(x0 + 1, _imageWidth - 1);
+		const int y1 = glm::min(y0 + 1, _imageHeight - 1);
+
+		const float fx = glm::clamp(_x - x0, 0.0f, 1.0f);
+		const float fy = glm::clamp(_y - y0, 0.0f, 1.0f);
+
+		const float top = glm::mix(GetPixelHeight(_data, x0, y0, _imageWidth, _channels, _maxValue), GetPixelHeight(_data, x1, y0, _imageWidth, _channels, _maxValue), fx);
+		const float bottom = glm::mix(GetPixelHeight(_data, x0, y1, _imageWidth, _channels, _maxValue), GetPixelHeight(_data, x1, y1, _imageWidth, _channels, _maxValue), fx);
+
+		return glm::mix(top, bottom, fy);
+	}
+
+	void Terrain::CreateTiles()
 	{
 		nodeCountX = (length / gridLength) + 1;
 		nodeCountZ = (breadth / gridBreadth) + 1;
 
-		tiles = new MapTile*[nodeCountX];
+		const size_t tile_count = size_t(nodeCountX) * nodeCountZ;
 
-		for (auto i = 0; i < nodeCountX; i++) {
-			tiles[i] = new MapTile[nodeCountZ];
-		}
+		// One Block for all of them. A new Terrain replaces the old Block, if there was one.
+		tiles.reset(new MapTile[tile_count]);
 
-		// Load the Image.
-		stbi_set_flip_vertically_on_load(true);
-		int image_width, image_height, nr_channels;
+		// 16 bit Height Maps are kept as they are, so that they do not end up in Terraces.
+		unsigned char * data = nullptr;
+		unsigned short * data_16 = nullptr;
+		int image_width = 0, image_height = 0, nr_channels = 0;
+
+		if (!heightFunction)
+		{
+			// Load the Image.
+			stbi_set_flip_vertically_on_load(true);
 
-		auto data = stbi_load(heightMapFile.c_str(), &image_width, &image_height, &nr_channels, 0);
+			if (stbi_is_16_bit(heightMapFile.c_str()))
+			{
+				data_16 = stbi_load_16(heightMapFile.c_str(), &image_width, &image_height, &nr_channels, 0);
+			}
+			else
+			{
+				data = stbi_load(heightMapFile.c_str(), &image_width, &image_height, &nr_channels, 0);
+			}
 
-		if (NULL == data) {
-			LOGGER.AddToLog("Unable to load " + heightMapFile, PE_LOG_ERROR);
+			if (NULL == data && NULL == data_16) {
+				LOGGER.AddToLog("Unable to load " + heightMapFile, PE_LOG_ERROR);
+			}
 		}
 
-		for (auto i = 0; i < nodeCountX; i++)
+		// The Corner Nodes sample the Corner Pixels.
+		const float pixels_per_node_x = (nodeCountX > 1) ? float(image_width - 1) / (nodeCountX - 1) : 0.0f;
+		const float pixels_per_node_z = (nodeCountZ > 1) ? float(image_height - 1) / (nodeCountZ - 1) : 0.0f;
+
+		nodeHeights.resize(tile_count);
+
+		navCosts.assign(tile_count, 0.0f);
+		navWalkableTiles.Assign(tile_count, true);
+		navObstacleTiles.Assign(tile_count, false);
+		occupiedTiles.Assign(tile_count, false);
+		tileOccupants.assign(tile_count, nullptr);
+
+		// Each Row of Tiles is on its own, so they are spread over the Workers.
+		WORKERPOOL.ParallelFor(nodeCountX, [&](unsigned int _i, unsigned int)
 		{
+			const int i = _i;
+
 			for (auto j = 0; j < nodeCountZ; j++)
 			{
-				auto image_x = int(i * image_width / nodeCountX);
-				auto image_z = int(j * image_height / nodeCountZ);
-
 				float total = 0;
 
-				const auto channels_without_alpha = (nr_channels == 2 || nr_channels == 4) ? (nr_channels - 1) : nr_channels;
-
-				// Do not count the Alpha
-				for (auto it = 0; it < channels_without_alpha; it++)
+				if (heightFunction)
+				{
+					total = heightFunction(float(i) / nodeCountX, float(j) / nodeCountZ);
+				}
+				else if (nullptr != data_16)
+				{
+					total = SampleHeightMap(data_16, i * pixels_per_node_x, j * pixels_per_node_z, image_width, image_height, nr_channels, 65535.0f);
+				}
+				else if (nullptr != data)
 				{
-					total += int(data[((image_x + (image_z * image_width)) * nr_channels)] + it);
+					total = SampleHeightMap(data, i * pixels_per_node_x, j * pixels_per_node_z, image_width, image_height, nr_channels, 255.0f);
 				}
 
-				// To make it so that, the blacks are higher and the whites are lower, we subtract the values from pure white.
-				total = ((255.0f * channels_without_alpha) - total) / (channels_without_alpha * 255.0f);
+				MapTile& tile = tiles[i * nodeCountZ + j];
 
-				tiles[i][j].tileIndexX = i;
-				tiles[i][j].tileIndexZ = j;
+				tile.tileIndexX = i;
+				tile.tileIndexZ = j;
 
-				tiles[i][j].tilePosX = i * gridLength + gridLength / 2;
-				tiles[i][j].tilePosZ = j * gridBreadth + gridBreadth / 2;
+				tile.tilePosX = i * gridLength + gridLength / 2;
+				tile.tilePosZ = j * gridBreadth + gridBreadth / 2;
 
-				tiles[i][j].tilePosY = total * heightFactor;
+				nodeHeights[i * nodeCountZ + j] = total * heightFactor;
 			}
-		}
+		});
+
+		heightTree.Build(&nodeHeights[0], nodeCountX, nodeCountZ, TERRAIN_PATCH_QUADS);
 
 		// Freeing the Image Data.
 		stbi_image_free(data);
+		stbi_image_free(data_16);
+	}
 
+	void Terrain::BuildMeshData()
+	{
 		this->vertices.resize(nodeCountX * nodeCountZ);
 
 		for (auto i = 0; i < nodeCountX; i++) {
 			for (auto j = 0; j < nodeCountZ; j++) {
 				vertices[i * nodeCountZ + j] = TerrainVertexData();
-				vertices[i * nodeCountZ + j].position = glm::vec4(tiles[i][j].tilePosX, tiles[i][j].tilePosY, tiles[i][j].tilePosZ, 0.0f);
+				vertices[i * nodeCountZ + j].position = glm::vec4(tiles[i * nodeCountZ + j].tilePosX, nodeHeights[i * nodeCountZ + j], tiles[i * nodeCountZ + j].tilePosZ, 0.0f);
 				vertices[i * nodeCountZ + j].normal = glm::vec4();
-				vertices[i * nodeCountZ + j].colour = (tiles[i][j].navWalkable) ? glm::vec4(green, 1.0f) : glm::vec4(red, 1.0f);
-				vertices[i * nodeCountZ + j].texCoord = glm::vec4(i * 0.4, j * 0.4, 0.5, 0);
+				vertices[i * nodeCountZ + j].texCoord = glm::vec4(i * 0.4, j * 0.4, 0.0, 0);
+			}
+		}
+
+		tileStates.assign(vertices.size() * 4, 0);
+		tileStateRowDirty.assign(nodeCountX, 0);
+		dirtyTileStateRows.clear();
+		highlightedTiles.clear();
+
+		for (auto i = 0; i < nodeCountX; i++) {
+			for (auto j = 0; j < nodeCountZ; j++) {
+				ResetNodeColour(i, j);
 			}
 		}
 
+		// The whole Texture is created from these, so nothing is dirty yet.
+		std::fill(tileStateRowDirty.begin(), tileStateRowDirty.end(), 0);
+		dirtyTileStateRows.clear();
+
+		indices.clear();
+
 		for (auto i = 0; i < nodeCountX - 1; i++)
 		{
 			for (auto j = 0; j < nodeCountZ - 1; j++)
@@ -154,19 +344,178 @@ namespace pilot {
 			}
 		}
 
-		for (auto i = 0; i < nodeCountX; i++)
+		ComputeNormals(glm::ivec2(0, 0), glm::ivec2(nodeCountX - 1, nodeCountZ - 1));
+		areHeightsDirty = false;
+
+		ResetLodSelection();
+	}
+
+	void Terrain::ResetLodSelection()
+	{
+		const int quads_x = glm::max(int(nodeCountX) - 1, 1);
+		const int quads_z = glm::max(int(nodeCountZ) - 1, 1);
+
+		lodSelection.clear();
+		lodPatchLevels.assign(((quads_x + TERRAIN_PATCH_QUADS - 1) / TERRAIN_PATCH_QUADS) * ((quads_z + TERRAIN_PATCH_QUADS - 1) / TERRAIN_PATCH_QUADS), 0);
+	}
+
+	void Terrain::SelectLodNode(int _x, int _z, int _level, const std::vector<glm::vec3>& _cameraPositions)
+	{
+		const int quads_x = int(nodeCountX) - 1;
+		const int quads_z = int(nodeCountZ) - 1;
+
+		if (_x >= quads_x || _z >= quads_z)
+		{
+			return;
+		}
+
+		const int node_size = TERRAIN_PATCH_QUADS << _level;
+
+		if (_level > 0)
 		{
-			for (auto j = 0; j < nodeCountZ; j++) {
+			const glm::vec2& height_range = heightTree.GetRange(_level, _x / node_size, _z / node_size);
+
+			// The Vertices sit in the middle of the Tiles.
+			const glm::vec3 box_min(_x * gridLength + gridLength / 2, height_range.x, _z * gridBreadth + gridBreadth / 2);
+			const glm::vec3 box_max(glm::min(_x + node_size, quads_x) * gridLength + gridLength / 2, height_range.y, glm::min(_z + node_size, quads_z) * gridBreadth + gridBreadth / 2);
+
+			const float split_distance = lodRange * node_size * glm::max(gridLength, gridBreadth);
+
+			for (const auto& camera_position : _cameraPositions)
+			{
+				const glm::vec3 nearest = glm::clamp(camera_position, box_min, box_max);
+
+				if (glm::length(camera_position - nearest) < split_distance)
+				{
+					const int child_size = node_size / 2;
+
+					SelectLodNode(_x, _z, _level - 1, _cameraPositions);
+					SelectLodNode(_x + child_size, _z, _level - 1, _cameraPositions);
+					SelectLodNode(_x, _z + child_size, _level - 1, _cameraPositions);
+					SelectLodNode(_x + child_size, _z + child_size, _level - 1, _cameraPositions);
+
+					return;
+				}
+			}
+		}
+
+		lodSelection.emplace_back(_x, _z, _level);
+	}
+
+	void Terrain::AddLodNodeIndices(const glm::ivec3& _node)
+	{
+		const int quads_x = int(nodeCountX) - 1;
+		const int quads_z = int(nodeCountZ) - 1;
+		const int patch_count_z = (quads_z + TERRAIN_PATCH_QUADS - 1) / TERRAIN_PATCH_QUADS;
+
+		const int stride = 1 << _node.z;
+		const int node_size = TERRAIN_PATCH_QUADS * stride;
+
+		const int x_end = _node.x + node_size;
+		const int z_end = _node.y + node_size;
+
+		// The Stride of the Neighbour on each Edge, if it is coarser. A coarser Neighbour covers the whole Edge, so checking its first Patch is enough.
+		const auto neighbour_stride = [&](int _patchX, int _patchZ)
+		{
+			const int level = lodPatchLevels[_patchX * patch_count_z + _patchZ];
+			return (level > _node.z) ? (1 << level) : 1;
+		};
+
+		const int stride_min_x = (_node.x > 0) ? neighbour_stride(_node.x / TERRAIN_PATCH_QUADS - 1, _node.y / TERRAIN_PATCH_QUADS) : 1;
+		const int stride_max_x = (x_end < quads_x) ? neighbour_stride(x_end / TERRAIN_PATCH_QUADS, _node.y / TERRAIN_PATCH_QUADS) : 1;
+		const int stride_min_z = (_node.y > 0) ? neighbour_stride(_node.x / TERRAIN_PATCH_QUADS, _node.y / TERRAIN_PATCH_QUADS - 1) : 1;
+		const int stride_max_z = (z_end < quads_z) ? neighbour_stride(_node.x / TERRAIN_PATCH_QUADS, z_end / TERRAIN_PATCH_QUADS) : 1;
+
+		const auto vertex_index = [&](int _x, int _z) -> unsigned int
+		{
+			// Snap the Vertices on an Edge onto the Vertices of the coarser Neighbour there, along the Edge.
+			if (_x == _node.x) { _z = (_z / stride_min_x) * stride_min_x; }
+			else if (_x == x_end) { _z = (_z / stride_max_x) * stride_max_x; }
+
+			if (_z == _node.y) { _x = (_x / stride_min_z) * stride_min_z; }
+			else if (_z == z_end) { _x = (_x / stride_max_z) * stride_max_z; }
+
+			// The Nodes on the far Edges of the Terrain can stick out of it.
+			return glm::min(_x, quads_x) * nodeCountZ + glm::min(_z, quads_z);
+		};
+
+		const auto add_triangle = [this](unsigned int _a, unsigned int _b, unsigned int _c)
+		{
+			// Snapping collapses some of the Triangles on the Edges.
+			if (_a != _b && _b != _c && _a != _c)
+			{
+				indices.push_back(_a);
+				indices.push_back(_b);
+				indices.push_back(_c);
+			}
+		};
+
+		for (auto i = _node.x; i < x_end && i < quads_x; i += stride)
+		{
+			for (auto j = _node.y; j < z_end && j < quads_z; j += stride)
+			{
+				add_triangle(vertex_index(i, j), vertex_index(i, j + stride), vertex_index(i + stride, j));
+				add_triangle(vertex_index(i + stride, j), vertex_index(i, j + stride), vertex_index(i + stride, j + stride));
+			}
+		}
+	}
 
-				vertices[i * nodeCountZ + j].normal = glm::vec4(ComputeGridNormal(i, j), 0.0);
+	void Terrain::SelectLod(const std::vector<glm::vec3>& _cameraPositions)
+	{
+		if (0 == heightTree.GetLevelCount())
+		{
+			return;
+		}
+
+		const auto previous_selection = std::move(lodSelection);
+		lodSelection.clear();
+
+		SelectLodNode(0, 0, heightTree.GetLevelCount() - 1, _cameraPositions);
+
+		if (lodSelection == previous_selection)
+		{
+			return;
+		}
 
+		const int patch_count_z = (int(nodeCountZ) - 1 + TERRAIN_PATCH_QUADS - 1) / TERRAIN_PATCH_QUADS;
+		const int patch_count_x = (int(nodeCountX) - 1 + TERRAIN_PATCH_QUADS - 1) / TERRAIN_PATCH_QUADS;
+
+		for (const auto& node : lodSelection)
+		{
+			const int patches = 1 << node.z;
+
+			for (auto i = node.x / TERRAIN_PATCH_QUADS; i < glm::min(node.x / TERRAIN_PATCH_QUADS + patches, patch_count_x); i++)
+			{
+				for (auto j = node.y / TERRAIN_PATCH_QUADS; j < glm::min(node.y / TERRAIN_PATCH_QUADS + patches, patch_count_z); j++)
+				{
+					lodPatchLevels[i * patch_count_z + j] = static_cast<unsigned char>(node.z);
+				}
 			}
 		}
 
+		indices.clear();
+
+		for (const auto& node : lodSelection)
+		{
+			AddLodNodeIndices(node);
+		}
+
+		if (nullptr != objectPtr)
+		{
+			objectPtr->GetMeshes()[0]->UpdateIndices(indices);
+		}
+	}
+
+	void Terrain::UploadMesh()
+	{
+		tileStateTexture = std::make_shared<Texture>(nodeCountZ, nodeCountX, &tileStates[0]);
 
+		if (!ASMGR.AddToTextures("terrain_state", tileStateTexture)) {
+			LOGGER.AddToLog("Cannot load the terrain state into AssetManager", PE_LOG_ERROR);
+		}
 
 		auto mesh = std::make_shared<Mesh>(&vertices[0], sizeof(TerrainVertexData), vertices.size(), indices);
-		mesh->SetTextureNames(std::vector<std::string>{"grass"});
+		mesh->SetTextureNames(std::vector<std::string>{"grass", "terrain_state"});
 
 		objectPtr = std::make_shared<Object>("terrain", std::vector<std::shared_ptr<Mesh>>{mesh});
 
@@ -176,9 +525,6 @@ namespace pilot {
 
 		this->objectName = "terrain";
 		this->shaderName = "terrain";
-
-		// Load Stuff for PathFinding
-		InitPathFinding();
 	}
 
 	void Terrain::Render()
@@ -190,22 +536,151 @@ namespace pilot {
 	{
 		Entity::Update(_delatTime);
 
-		if (this->areVerticesDirty) {
-			this->objectPtr->GetMeshes()[0]->UpdateVertices(&vertices[0], sizeof(TerrainVertexData), vertices.size());
-			areVerticesDirty = false;
+		if (areHeightsDirty) {
+
+			heightTree.Refit(&nodeHeights[0], dirtyHeightsMin, dirtyHeightsMax);
+			areHeightsDirty = false;
+
+			if (!vertices.empty()) {
+				ComputeNormals(dirtyHeightsMin, dirtyHeightsMax);
+			}
+
+			if (nullptr != this->objectPtr) {
+
+				const int first_z = glm::max(dirtyHeightsMin.y, 0);
+				const int last_z = glm::min(dirtyHeightsMax.y, int(nodeCountZ) - 1);
+
+				// Each Row of the Rectangle is next to each other in the Buffer.
+				for (auto i = glm::max(dirtyHeightsMin.x, 0); i <= glm::min(dirtyHeightsMax.x, int(nodeCountX) - 1); i++)
+				{
+					this->objectPtr->GetMeshes()[0]->UpdateVertexRange(&vertices[i * nodeCountZ + first_z], sizeof(TerrainVertexData), i * nodeCountZ + first_z, last_z - first_z + 1);
+				}
+			}
+		}
+
+		if (dirtyTileStateRows.empty()) {
+			return;
+		}
+
+		// Without a Texture, there is nothing to upload to. UploadMesh creates it from all the Tile States anyway.
+		if (nullptr != this->tileStateTexture) {
+
+			std::sort(dirtyTileStateRows.begin(), dirtyTileStateRows.end());
+
+			// Rows next to each other go up in one call.
+			for (size_t first = 0; first < dirtyTileStateRows.size();)
+			{
+				size_t last = first;
+
+				while (last + 1 < dirtyTileStateRows.size() && dirtyTileStateRows[last + 1] == dirtyTileStateRows[last] + 1)
+				{
+					last++;
+				}
+
+				const unsigned int first_row = dirtyTileStateRows[first];
+				const unsigned int row_count = dirtyTileStateRows[last] - first_row + 1;
+
+				this->tileStateTexture->UpdateRows(first_row, row_count, &tileStates[first_row * nodeCountZ * 4]);
+
+				first = last + 1;
+			}
+		}
+
+		for (const auto row : dirtyTileStateRows)
+		{
+			tileStateRowDirty[row] = 0;
 		}
 
+		dirtyTileStateRows.clear();
+
+	}
+
+	float Terrain::GetHeightAtPos(const float& _x, const float& _z) const
+	{
+		float height = 0.0f;
+		GetHeightsAtPositions(&_x, &_z, &height, 1);
+		return height;
 	}
 
-	float Terrain::GetHeightAtPos(const float& _x, const float& _z)
+	void Terrain::GetHeightsAtPositions(const float * _x, const float * _z, float * _heights, size_t _count) const
 	{
-		auto temp = GetNodeIndicesFromPos(_x, _z);
-		return GetHeightForNode(temp.x, temp.y);
+		if (nodeCountX < 2 || nodeCountZ < 2)
+		{
+			std::fill(_heights, _heights + _count, nodeHeights.empty() ? 0.0f : nodeHeights[0]);
+			return;
+		}
+
+		// The Vertices are in the middle of the Tiles. In Quads, Node ( i, j ) is at ( i, j ).
+		const float last_quad_x = float(nodeCountX - 2);
+		const float last_quad_z = float(nodeCountZ - 2);
+		const float * heights = &nodeHeights[0];
+		const unsigned int stride = nodeCountZ;
+
+		size_t k = 0;
+
+#if defined(_M_X64) || defined(__SSE2__)
+
+		const __m128 half_grid_x = _mm_set1_ps(gridLength / 2), inverse_grid_x = _mm_set1_ps(1.0f / gridLength);
+		const __m128 half_grid_z = _mm_set1_ps(gridBreadth / 2), inverse_grid_z = _mm_set1_ps(1.0f / gridBreadth);
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		const __m128 last_quad_x_4 = _mm_set1_ps(last_quad_x), last_quad_z_4 = _mm_set1_ps(last_quad_z);
+
+		for (; k + 4 <= _count; k += 4)
+		{
+			// Clamp onto the Terrain, so that anything outside gets the Height at its Edge.
+			const __m128 u = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_x + k), half_grid_x), inverse_grid_x), zero), _mm_add_ps(last_quad_x_4, one));
+			const __m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_z + k), half_grid_z), inverse_grid_z), zero), _mm_add_ps(last_quad_z_4, one));
+
+			const __m128 quad_x = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(u)), last_quad_x_4);
+			const __m128 quad_z = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(v)), last_quad_z_4);
+
+			const __m128 fraction_x = _mm_sub_ps(u, quad_x);
+			const __m128 fraction_z = _mm_sub_ps(v, quad_z);
+
+			alignas(16) int quad_xs[4], quad_zs[4];
+			_mm_store_si128(reinterpret_cast<__m128i *>(quad_xs), _mm_cvttps_epi32(quad_x));
+			_mm_store_si128(reinterpret_cast<__m128i *>(quad_zs), _mm_cvttps_epi32(quad_z));
+
+			// SSE2 has no Gather, so the Corners are loaded one by one.
+			alignas(16) float h_00[4], h_01[4], h_10[4], h_11[4];
+
+			for (auto lane = 0; lane < 4; lane++)
+			{
+				const float * corner = heights + quad_xs[lane] * stride + quad_zs[lane];
+				h_00[lane] = corner[0];
+				h_01[lane] = corner[1];
+				h_10[lane] = corner[stride];
+				h_11[lane] = corner[stride + 1];
+			}
+
+			const __m128 near_x = _mm_add_ps(_mm_load_ps(h_00), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h_10), _mm_load_ps(h_00)), fraction_x));
+			const __m128 far_x = _mm_add_ps(_mm_load_ps(h_01), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(h_11), _mm_load_ps(h_01)), fraction_x));
+
+			_mm_storeu_ps(_heights + k, _mm_add_ps(near_x, _mm_mul_ps(_mm_sub_ps(far_x, near_x), fraction_z)));
+		}
+
+#endif
+
+		for (; k < _count; k++)
+		{
+			const float u = glm::clamp((_x[k] - gridLength / 2) / gridLength, 0.0f, last_quad_x + 1.0f);
+			const float v = glm::clamp((_z[k] - gridBreadth / 2) / gridBreadth, 0.0f, last_quad_z + 1.0f);
+
+			const float quad_x = glm::min(std::floor(u), last_quad_x);
+			const float quad_z = glm::min(std::floor(v), last_quad_z);
+
+			const float * corner = heights + int(quad_x) * stride + int(quad_z);
+
+			const float near_x = corner[0] + (corner[stride] - corner[0]) * (u - quad_x);
+			const float far_x = corner[1] + (corner[stride + 1] - corner[1]) * (u - quad_x);
+
+			_heights[k] = near_x + (far_x - near_x) * (v - quad_z);
+		}
 	}
 
 	float Terrain::GetHeightForNode(const int& _x, const int& _z)
 	{
-		return tiles[_x][_z].tilePosY;
+		return nodeHeights[_x * nodeCountZ + _z];
 	}
 
 	glm::ivec2 Terrain::GetNodeIndicesFromPos(const glm::vec3 _position)
@@ -228,11 +703,37 @@ namespace pilot {
 		return return_vec;
 	}
 
+	void Terrain::SetTileState(unsigned int _x, unsigned int _z, const glm::vec3& _colour, float _highlight)
+	{
+		unsigned char * state = &tileStates[(_x * nodeCountZ + _z) * 4];
+
+		const unsigned char new_state[4] = {
+			(unsigned char)(_colour.r * 255.0f), (unsigned char)(_colour.g * 255.0f), (unsigned char)(_colour.b * 255.0f), (unsigned char)(_highlight * 255.0f)
+		};
+
+		if (std::equal(new_state, new_state + 4, state))
+		{
+			return;
+		}
+
+		std::copy(new_state, new_state + 4, state);
+
+		if (!tileStateRowDirty[_x])
+		{
+			tileStateRowDirty[_x] = 1;
+			dirtyTileStateRows.push_back(_x);
+		}
+	}
+
+	void Terrain::ResetNodeColour(unsigned int _x, unsigned int _z)
+	{
+		SetTileState(_x, _z, IsTilePassable(_x * nodeCountZ + _z) ? green : red, 0.5f);
+	}
+
 	void Terrain::HighlightNode(unsigned int _x, unsigned int _z)
 	{
-		this->vertices[_x * nodeCountZ + _z].colour = glm::vec4(yellow, 1.0f);
-		this->vertices[_x * nodeCountZ + _z].texCoord.z = 1.0f;
-		areVerticesDirty = true;
+		SetTileState(_x, _z, yellow, 1.0f);
+		highlightedTiles.push_back(_x * nodeCountZ + _z);
 	}
 
 	bool Terrain::CanPlaceHere(unsigned _x, unsigned _z)
@@ -262,10 +763,10 @@ namespace pilot {
 				// i , line number to make sure.
 				for (int i221 = 0; i221 < 8; i221++)
 				{
-					colour_red |= neighbours[i221]->navObstacle;
+					colour_red |= IsTileObstacle(GetTileIndex(neighbours[i221]));
 				}
 
-				colour_red |= current_tile->navObstacle;
+				colour_red |= IsTileObstacle(GetTileIndex(current_tile));
 
 				return !colour_red;
 
@@ -278,156 +779,489 @@ namespace pilot {
 
 	void Terrain::ClearColours()
 	{
-
-		/*auto all_tile_sets = GetAllTileSets();
-		auto number_tile_sets = all_tile_sets.size();*/
-
-		for (auto i = 0; i < nodeCountX; i++) {
-			for (auto j = 0; j < nodeCountZ; j++) {
-
-				/*int index = std::distance( all_tile_sets.begin(), std::find(all_tile_sets.begin(), all_tile_sets.end(), tiles[i][j].navTileSet));
-
-				this->vertices[i * nodeCountZ + j].colour = glm::vec4( red * (float(index) / number_tile_sets), 0.0f);
-				this->vertices[i * nodeCountZ + j].texCoord.z = 0.5f;*/
-				vertices[i * nodeCountZ + j].colour = (tiles[i][j].navWalkable && !tiles[i][j].navObstacle) ? glm::vec4(green, 1.0f) : glm::vec4(red, 1.0f);
-				this->vertices[i * nodeCountZ + j].texCoord.z = 0.5f;
-			}
+		// Only the Highlighted Nodes have anything to clear. The Obstacles colour their Nodes when they are placed.
+		for (const auto tile_index : highlightedTiles)
+		{
+			ResetNodeColour(tile_index / nodeCountZ, tile_index % nodeCountZ);
 		}
-		areVerticesDirty = true;
 
+		highlightedTiles.clear();
 	}
 
-	float HCost(MapTile * _pointA, MapTile * _pointB)
+	float Terrain::HCost(const MapTile * _pointA, const MapTile * _pointB) const
 	{
-		if ( _pointA->navWalkable && _pointB->navWalkable )
+		if (PE_HEURISTIC_MANHATTAN == navHeuristic)
 		{
-			return abs(_pointA->tilePosX - _pointB->tilePosX) + abs(_pointA->tilePosZ - _pointB->tilePosZ);
+			return std::abs(_pointA->tilePosX - _pointB->tilePosX) + std::abs(_pointA->tilePosZ - _pointB->tilePosZ);
 		}
 
-		return INT_MAX;
+		if (PE_HEURISTIC_LANDMARKS == navHeuristic)
+		{
+			return GetPathCostLowerBound(GetTileIndex(_pointA), GetTileIndex(_pointB));
+		}
+
+		// Every step costs at least the cheapest Tile, and it takes at least this many steps.
+		return float(std::max(std::abs(_pointA->tileIndexX - _pointB->tileIndexX), std::abs(_pointA->tileIndexZ - _pointB->tileIndexZ))) * navMinCost;
 	}
 
-	std::vector<MapTile *> Terrain::GetPathFromTiles(MapTile * _startTile, MapTile * _endTile)
+	float Terrain::GetPathCostLowerBound(int _fromTileIndex, int _toTileIndex) const
 	{
-		std::vector<MapTile*> return_vector;
+		const int dx = std::abs(_fromTileIndex / int(nodeCountZ) - _toTileIndex / int(nodeCountZ));
+		const int dz = std::abs(_fromTileIndex % int(nodeCountZ) - _toTileIndex % int(nodeCountZ));
+
+		// Every step costs at least the cheapest Tile, and it takes at least this many steps.
+		float estimate = float(std::max(dx, dz)) * navMinCost;
 
-		if ( _startTile->navTileSet != _endTile->navTileSet)
+		if (!navLandmarks.empty())
 		{
-			// They are not in the same tile set. Return the empty stuff.
-			return return_vector;
-		}
+			// Getting from A to a Landmark never costs more than going through B: d(A, L) <= d(A, B) + d(B, L).
+			const float * distances_a = &navLandmarkDistances[size_t(_fromTileIndex) * navLandmarkCount];
+			const float * distances_b = &navLandmarkDistances[size_t(_toTileIndex) * navLandmarkCount];
 
-		if (!_endTile->navWalkable) {
-			return return_vector;
+			for (auto i = 0u; i < navLandmarkCount; i++)
+			{
+				if (distances_a[i] < float(INT_MAX) && distances_b[i] < float(INT_MAX))
+				{
+					estimate = std::max(estimate, distances_a[i] - distances_b[i]);
+				}
+			}
 		}
 
-		// Make sure that they are not the same tiles.
-		if (_startTile == _endTile) {
-			return return_vector;
+		return estimate;
+	}
+
+	void Terrain::SetPathHeuristic(PathHeuristic _heuristic, unsigned int _landmarkCount)
+	{
+		navHeuristic = _heuristic;
+
+		if (PE_HEURISTIC_LANDMARKS == navHeuristic && (navLandmarkCount != _landmarkCount || navLandmarks.empty()))
+		{
+			navLandmarkCount = _landmarkCount;
+			BuildLandmarks();
 		}
+	}
+
+	void Terrain::BuildLandmarks()
+	{
+		const int tile_count = nodeCountX * nodeCountZ;
+
+		navLandmarks.clear();
+		navLandmarkDistances.assign(size_t(tile_count) * navLandmarkCount, float(INT_MAX));
+
+		// How far each Tile is from the closest Landmark so far. The next Landmark is the Tile where that is the largest.
+		std::vector<float> closest_landmark(tile_count, float(INT_MAX));
+		std::vector<float> distances(tile_count);
+
+		typedef std::pair<float, int> QueueEntry;
 
-		for ( auto i = 0 ; i < nodeCountX ; i++)
+		// We start from the first Walkable Tile. The first Landmark is the Tile farthest from there, so the Seed's own Search is thrown away.
+		int seed = -1;
+		for (auto i = 0; i < tile_count && seed < 0; i++)
 		{
-			for ( auto j = 0 ; j < nodeCountZ; j++)
+			if (IsTileWalkable(i))
 			{
-				tiles[i][j].navFCost = tiles[i][j].navGCost = INT_MAX;
-				tiles[i][j].navOpen = false;
-				tiles[i][j].navClosed = !tiles[i][j].navWalkable;
+				seed = i;
 			}
 		}
 
-		std::vector<MapTile *> open_set;
+		for (int landmark = -1; landmark < int(navLandmarkCount) && seed >= 0; landmark++)
+		{
+			// Dijkstra backwards from the Seed, over the Walkable Tiles. Stepping from a Tile costs its navCost, same as in GetPathFromTiles.
+			std::fill(distances.begin(), distances.end(), float(INT_MAX));
+			std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> open_queue;
 
-		_startTile->navGCost = 0.0f;
-		_startTile->navFCost = HCost(_startTile, _endTile);
-		_startTile->navOpen = true;
+			distances[seed] = 0.0f;
+			open_queue.push(QueueEntry(0.0f, seed));
 
-		open_set.push_back(_startTile);
+			while (!open_queue.empty())
+			{
+				const QueueEntry entry = open_queue.top();
+				open_queue.pop();
 
-		bool path_found = false;
+				if (entry.first > distances[entry.second])
+				{
+					continue;
+				}
 
-		while ( !path_found && !open_set.empty())
-		{
-			int best_node_index = 0;
+				const MapTile * tile = GetTileFromIndex(entry.second);
+
+				for (const auto& offset : MapTile::navDirectionOffsets)
+				{
+					const int x = tile->tileIndexX + offset.x;
+					const int z = tile->tileIndexZ + offset.y;
+
+					if (x < 0 || z < 0 || x >= int(nodeCountX) || z >= int(nodeCountZ) || !IsTileWalkable(x * nodeCountZ + z))
+					{
+						continue;
+					}
 
-			MapTile* active_node = open_set[best_node_index];
+					const int from_index = x * nodeCountZ + z;
+					const float new_cost = entry.first + navCosts[from_index];
 
-			for ( auto index = 0; index < open_set.size(); index++ )
+					if (new_cost < distances[from_index])
+					{
+						distances[from_index] = new_cost;
+						open_queue.push(QueueEntry(new_cost, from_index));
+					}
+				}
+			}
+
+			if (landmark >= 0)
 			{
-				if ( open_set[index]->navFCost < active_node->navFCost)
+				navLandmarks.push_back(seed);
+
+				for (auto i = 0; i < tile_count; i++)
 				{
-					active_node = open_set[index];
-					best_node_index = index;
+					navLandmarkDistances[size_t(i) * navLandmarkCount + landmark] = distances[i];
 				}
 			}
 
-			if (nullptr == active_node)
+			int farthest = -1;
+
+			for (auto i = 0; i < tile_count; i++)
 			{
-				// This means there is no path.
-				break;
+				if (distances[i] == float(INT_MAX))
+				{
+					continue;
+				}
+
+				// The Seed's own Search does not count. We only want its farthest Tile.
+				closest_landmark[i] = (landmark >= 0) ? std::min(closest_landmark[i], distances[i]) : distances[i];
+
+				if (farthest < 0 || closest_landmark[i] > closest_landmark[farthest])
+				{
+					farthest = i;
+				}
 			}
 
-			active_node->navOpen = false;
-			open_set.erase(open_set.begin() + best_node_index);
+			seed = farthest;
 
-			// Can we just check if they point to the same tile, since they are pointers.. Apparently we cant
-			if (_endTile->tileIndexX == active_node->tileIndexX && _endTile->tileIndexZ == active_node->tileIndexZ)
+			if (landmark < 0)
 			{
-				// We have reached the target. Retrace our Path.
-				std::vector<MapTile *> temp_path;
+				std::fill(closest_landmark.begin(), closest_landmark.end(), float(INT_MAX));
+			}
+		}
+
+		LOGGER.AddToLog("Built " + std::to_string(navLandmarks.size()) + " Landmarks for the A* Heuristic.", PE_LOG_INFO);
+	}
+
+	bool Terrain::IsNodePassable(int _x, int _z) const
+	{
+		if (_x < 0 || _z < 0 || _x >= int(nodeCountX) || _z >= int(nodeCountZ))
+		{
+			return false;
+		}
+
+		return IsTilePassable(_x * nodeCountZ + _z);
+	}
 
-				auto pathing_current_node = active_node;
+	int Terrain::JumpFrom(int _fromIndex, glm::ivec2 _direction, int _endIndex, float& _cost) const
+	{
+		const MapTile * from_tile = GetTileFromIndex(_fromIndex);
+
+		int x = from_tile->tileIndexX + _direction.x;
+		int z = from_tile->tileIndexZ + _direction.y;
 
-				while ( _startTile != pathing_current_node )
+		if (!IsNodePassable(x, z))
+		{
+			return -1;
+		}
+
+		_cost = navCosts[_fromIndex];
+
+		for (int distance = 1; ; distance++)
+		{
+			const int current_index = x * nodeCountZ + z;
+			const MapTile * current = &tiles[current_index];
+
+			// Outside the Uniform Cost regions, the pruning does not hold. Stop, and let A* expand it.
+			if (current_index == _endIndex || !current->navUniformCost || distance >= MAX_JUMP_DISTANCE)
+			{
+				return current_index;
+			}
+
+			if (_direction.x != 0 && _direction.y != 0)
+			{
+				if ((!IsNodePassable(x - _direction.x, z) && IsNodePassable(x - _direction.x, z + _direction.y)) ||
+					(!IsNodePassable(x, z - _direction.y) && IsNodePassable(x + _direction.x, z - _direction.y)))
 				{
-					temp_path.push_back(pathing_current_node);
-					pathing_current_node = pathing_current_node->navParent;
+					return current_index;
 				}
 
-				for (auto i : temp_path)
+				// A Diagonal Jump stops wherever one of its Straight Jumps finds something.
+				float straight_cost;
+				if (JumpFrom(current_index, glm::ivec2(_direction.x, 0), _endIndex, straight_cost) >= 0 ||
+					JumpFrom(current_index, glm::ivec2(0, _direction.y), _endIndex, straight_cost) >= 0)
+				{
+					return current_index;
+				}
+			}
+			else if (_direction.x != 0)
+			{
+				if ((!IsNodePassable(x, z + 1) && IsNodePassable(x + _direction.x, z + 1)) ||
+					(!IsNodePassable(x, z - 1) && IsNodePassable(x + _direction.x, z - 1)))
+				{
+					return current_index;
+				}
+			}
+			else
+			{
+				if ((!IsNodePassable(x + 1, z) && IsNodePassable(x + 1, z + _direction.y)) ||
+					(!IsNodePassable(x - 1, z) && IsNodePassable(x - 1, z + _direction.y)))
 				{
-					return_vector.push_back(i);
-					HighlightNode(i->tileIndexX, i->tileIndexZ);
+					return current_index;
 				}
+			}
+
+			// Uniform Cost Tiles are linked to all their Neighbours, so we only need to check the next one is passable.
+			if (!IsNodePassable(x + _direction.x, z + _direction.y))
+			{
+				return -1;
+			}
+
+			_cost += navCosts[current_index];
+			x += _direction.x;
+			z += _direction.y;
+		}
+	}
+
+	std::vector<MapTile *> Terrain::GetPathFromTiles(MapTile * _startTile, MapTile * _endTile)
+	{
+		auto return_vector = GetPathFromTiles(_startTile, _endTile, navContext);
+
+		for (auto i : return_vector)
+		{
+			HighlightNode(i->tileIndexX, i->tileIndexZ);
+		}
+
+		return return_vector;
+	}
+
+	std::vector<MapTile *> Terrain::GetPathFromTiles(const MapTile * _startTile, const MapTile * _endTile, PathFindingContext& _context) const
+	{
+		std::vector<MapTile*> return_vector;
 
-				return return_vector;
+		if (BeginPathSearch(_startTile, _endTile, _context))
+		{
+			ContinuePathSearch(_context, UINT_MAX, return_vector);
+		}
+
+		return return_vector;
+	}
+
+	bool Terrain::BeginPathSearch(const MapTile * _startTile, const MapTile * _endTile, PathFindingContext& _context) const
+	{
+		if ( !AreTilesConnected(_startTile, _endTile))
+		{
+			// They are not in the same tile set. Return the empty stuff.
+			return false;
+		}
+
+		if (!IsTileWalkable(GetTileIndex(_endTile))) {
+			return false;
+		}
+
+		// Make sure that they are not the same tiles.
+		if (_startTile == _endTile) {
+			return false;
+		}
+
+		// Instead of resetting every Tile, we start a new Search. Nodes reset themselves when the Search first touches them.
+		_context.BeginSearch(nodeCountX * nodeCountZ);
+
+		const int start_index = GetTileIndex(_startTile);
+		const int end_index = GetTileIndex(_endTile);
+
+		_context.SetSearchEnds(start_index, end_index);
+
+		SearchNode& start_node = _context.GetNode(start_index);
+		start_node.gCost = 0.0f;
+		start_node.fCost = HCost(_startTile, _endTile);
+		start_node.open = true;
+
+		_context.PushOpen(start_index);
+
+		return true;
+	}
+
+	PathSearchStatus Terrain::ContinuePathSearch(PathFindingContext& _context, unsigned int _maxExpansions, std::vector<MapTile *>& _path) const
+	{
+		const int start_index = _context.GetSearchStartIndex();
+		const int end_index = _context.GetSearchEndIndex();
+		const MapTile * _endTile = GetTileFromIndex(end_index);
+
+		unsigned int expansions = 0;
+
+		while (!_context.IsOpenSetEmpty())
+		{
+			// Out of budget. Everything we need to carry on is in the Context.
+			if (expansions == _maxExpansions)
+			{
+				return PE_SEARCH_IN_PROGRESS;
+			}
+
+			expansions++;
+
+			// The Heap always gives us the Tile with the least F Cost in the Open Set.
+			const int active_index = _context.PopOpen();
+			SearchNode& active_node = _context.GetNode(active_index);
+			const MapTile * active_tile = GetTileFromIndex(active_index);
+
+			active_node.open = false;
+			_context.CountExpansion();
+
+			if (end_index == active_index)
+			{
+				// We have reached the target. Retrace our Path.
+				auto pathing_current_index = active_index;
+
+				while ( start_index != pathing_current_index )
+				{
+					const int parent_index = _context.GetNode(pathing_current_index).parent;
+					const MapTile * parent_tile = GetTileFromIndex(parent_index);
+
+					// Jumps are straight or diagonal lines, so fill in the Tiles we jumped over.
+					int x = pathing_current_index / nodeCountZ;
+					int z = pathing_current_index % nodeCountZ;
+					const int step_x = (parent_tile->tileIndexX > x) - (parent_tile->tileIndexX < x);
+					const int step_z = (parent_tile->tileIndexZ > z) - (parent_tile->tileIndexZ < z);
+
+					while (x != parent_tile->tileIndexX || z != parent_tile->tileIndexZ)
+					{
+						_path.push_back(&tiles[x * nodeCountZ + z]);
+						x += step_x;
+						z += step_z;
+					}
+
+					pathing_current_index = parent_index;
+				}
+
+				return PE_SEARCH_FOUND;
 
 			}
 
 
-			for (auto i = 0 ; i < active_node->navNeighbourCount ; i++)
+			// The Directions to look in. Without a Parent, or outside the Uniform Cost regions, that is every Neighbour.
+			glm::ivec2 directions[8];
+			int direction_count = 0;
+
+			if (!navJumpPointSearch || active_node.parent < 0 || !active_tile->navUniformCost)
+			{
+				for (auto i = 0; i < 8; i++)
+				{
+					if (active_tile->CanStep(i))
+					{
+						directions[direction_count++] = MapTile::navDirectionOffsets[i];
+					}
+				}
+			}
+			else
 			{
-				// Check if the Neighbour has an obstacle or if it is in the closed list.
+				// Jump Point Search pruning. Only the natural Neighbours along the Direction we came in, and the forced ones next to Obstacles.
+				const MapTile * parent_tile = GetTileFromIndex(active_node.parent);
+				const int x = active_tile->tileIndexX;
+				const int z = active_tile->tileIndexZ;
+				const int dx = (x > parent_tile->tileIndexX) - (x < parent_tile->tileIndexX);
+				const int dz = (z > parent_tile->tileIndexZ) - (z < parent_tile->tileIndexZ);
+
+				if (dx != 0 && dz != 0)
+				{
+					directions[direction_count++] = glm::ivec2(dx, dz);
+					directions[direction_count++] = glm::ivec2(dx, 0);
+					directions[direction_count++] = glm::ivec2(0, dz);
+
+					if (!IsNodePassable(x - dx, z))
+					{
+						directions[direction_count++] = glm::ivec2(-dx, dz);
+					}
+					if (!IsNodePassable(x, z - dz))
+					{
+						directions[direction_count++] = glm::ivec2(dx, -dz);
+					}
+				}
+				else if (dx != 0)
+				{
+					directions[direction_count++] = glm::ivec2(dx, 0);
+
+					if (!IsNodePassable(x, z + 1))
+					{
+						directions[direction_count++] = glm::ivec2(dx, 1);
+					}
+					if (!IsNodePassable(x, z - 1))
+					{
+						directions[direction_count++] = glm::ivec2(dx, -1);
+					}
+				}
+				else
+				{
+					directions[direction_count++] = glm::ivec2(0, dz);
+
+					if (!IsNodePassable(x + 1, z))
+					{
+						directions[direction_count++] = glm::ivec2(1, dz);
+					}
+					if (!IsNodePassable(x - 1, z))
+					{
+						directions[direction_count++] = glm::ivec2(-1, dz);
+					}
+				}
+			}
+
+			for (auto i = 0 ; i < direction_count ; i++)
+			{
+				int neighbour_index;
+				float step_cost;
+
+				if (navJumpPointSearch)
+				{
+					neighbour_index = JumpFrom(active_index, directions[i], end_index, step_cost);
+				}
+				else
+				{
+					// Without the pruning, every Direction came from the Tile's Direction Mask. So the Neighbour is there, and Passable.
+					neighbour_index = active_index + directions[i].x * int(nodeCountZ) + directions[i].y;
+					step_cost = navCosts[active_index];
+				}
+
+				if (neighbour_index < 0)
+				{
+					continue;
+				}
+
+				const MapTile * neighbour = GetTileFromIndex(neighbour_index);
+				SearchNode& neighbour_node = _context.GetNode(neighbour_index);
+
 				// Closed set contains Nodes/Tiles that we have no intention of looking up again.
-				if ( nullptr != active_node->navNeighbours[i] && !active_node->navNeighbours[i]->navObstacle && !active_node->navNeighbours[i]->navClosed)
+				if ( !neighbour_node.closed)
 				{
-					const auto new_g = active_node->navGCost + active_node->navCost;
-					const auto new_f = new_g + HCost(active_node->navNeighbours[i], _endTile);
+					const auto new_g = active_node.gCost + step_cost;
+					const auto new_f = new_g + HCost(neighbour, _endTile);
 						
 					// Check if B is in the open list
-					if ( active_node->navNeighbours[i]->navOpen)
+					if ( neighbour_node.open)
 					{
-						if ((active_node->navNeighbours[i]->navWalkable) && (new_f < active_node->navNeighbours[i]->navFCost))
+						if (new_f < neighbour_node.fCost)
 						{
-							active_node->navNeighbours[i]->navGCost = new_g;
-							active_node->navNeighbours[i]->navFCost = new_f;
-							active_node->navNeighbours[i]->navParent = active_node;
+							neighbour_node.gCost = new_g;
+							neighbour_node.fCost = new_f;
+							neighbour_node.parent = active_index;
+							_context.DecreaseKey(neighbour_index);
 						}
 					} // If it doesn't exist in the Closed List as well.
-					else if (!active_node->navNeighbours[i]->navClosed)
+					else
 					{
 						// If it is not in Open or Closed Sets, Add it to the open list.
-						active_node->navNeighbours[i]->navGCost = new_g;
-						active_node->navNeighbours[i]->navFCost = new_f;
-						active_node->navNeighbours[i]->navParent = active_node;
-						active_node->navNeighbours[i]->navOpen = true;
-						open_set.push_back(active_node->navNeighbours[i]);
+						neighbour_node.gCost = new_g;
+						neighbour_node.fCost = new_f;
+						neighbour_node.parent = active_index;
+						neighbour_node.open = true;
+						_context.PushOpen(neighbour_index);
 					}
 
 				}
 			}
 
-			active_node->navClosed = true;
+			active_node.closed = true;
 		}
 
 		// TODO: Further reading is required.
@@ -444,7 +1278,7 @@ namespace pilot {
 		// If the open list turns up empty, then there is no path.
 		// Build the path by traversing the parent pointer of the Goal Node to Start and then reverse it.
 
-		return return_vector;
+		return PE_SEARCH_NOT_FOUND;
 	}
 
 	std::vector<MapTile *> Terrain::GetPathFromPositions(glm::vec3 _startPosition, glm::vec3 _endPosition)
@@ -463,150 +1297,667 @@ namespace pilot {
 
 	}
 
+	std::vector<std::vector<MapTile *>> Terrain::GetPathsFromPositions(const std::vector<PathRequest>& _requests)
+	{
+		std::vector<std::vector<MapTile *>> return_paths(_requests.size());
+
+		navWorkerContexts.resize(WORKERPOOL.GetWorkerCount());
+
+		if (std::any_of(_requests.begin(), _requests.end(), [](const PathRequest& _request) { return nullptr != _request.planner; }))
+		{
+			BuildPlannerLandmarks();
+		}
+
+		// Each Worker only ever uses its own Context, and the Planners of its own Requests, and writes only to its own slots of the result.
+		WORKERPOOL.ParallelFor(static_cast<unsigned int>(_requests.size()), [&](unsigned int _index, unsigned int _workerIndex)
+		{
+			const auto start_node_indices = GetNodeIndicesFromPos(_requests[_index].startPosition.x, _requests[_index].startPosition.z);
+			const auto end_node_indices = GetNodeIndicesFromPos(_requests[_index].endPosition.x, _requests[_index].endPosition.z);
+
+			if (nullptr != _requests[_index].planner)
+			{
+				return_paths[_index] = RunPlanner(
+					*_requests[_index].planner,
+					start_node_indices.x * nodeCountZ + start_node_indices.y,
+					end_node_indices.x * nodeCountZ + end_node_indices.y,
+					_requests[_index].smoothed
+				);
+				return;
+			}
+
+			const MapTile * start_tile = GetTileFromIndices(start_node_indices.x, start_node_indices.y);
+
+			return_paths[_index] = GetPathFromTiles(start_tile, GetTileFromIndices(end_node_indices.x, end_node_indices.y), navWorkerContexts[_workerIndex]);
+
+			if (_requests[_index].smoothed)
+			{
+				return_paths[_index] = SmoothPath(start_tile, return_paths[_index]);
+			}
+		});
+
+		// Highlighting writes to the Vertices. So, do it back on this thread. A Planner still has every Tile of a smoothed Path.
+		for (auto i = 0u; i < _requests.size(); i++)
+		{
+			for (auto tile : (nullptr != _requests[i].planner) ? _requests[i].planner->GetPath() : return_paths[i])
+			{
+				HighlightNode(tile->tileIndexX, tile->tileIndexZ);
+			}
+		}
+
+		return return_paths;
+	}
+
+	std::shared_ptr<FlowField> Terrain::GetFlowField(const std::vector<glm::ivec2>& _goalNodes)
+	{
+		// Forget the Fields nobody is following anymore.
+		navFlowFields.erase(
+			std::remove_if(navFlowFields.begin(), navFlowFields.end(), [](const std::shared_ptr<FlowField>& _field) { return _field.use_count() == 1; }),
+			navFlowFields.end()
+		);
+
+		for (const auto& field : navFlowFields)
+		{
+			if (field->GetGoalNodes() == _goalNodes && field->GetObstacleVersion() == navObstacleVersion)
+			{
+				return field;
+			}
+		}
+
+		auto field = std::make_shared<FlowField>(_goalNodes);
+		field->Build(*this);
+		navFlowFields.push_back(field);
+
+		return field;
+	}
+
+	MapTile * Terrain::GetFlowFieldNextTile(FlowField& _flowField, glm::vec3 _position)
+	{
+		if (_flowField.GetObstacleVersion() != navObstacleVersion)
+		{
+			_flowField.Build(*this);
+		}
+
+		const auto node_indices = GetNodeIndicesFromPos(_position.x, _position.z);
+		const int next_index = _flowField.GetNextTileIndex(GetTileIndex(GetTileFromIndices(node_indices)));
+
+		return (next_index < 0) ? nullptr : GetTileFromIndex(next_index);
+	}
+
+	bool Terrain::HasLineOfSight(const MapTile * _fromTile, const MapTile * _toTile) const
+	{
+		int x = _fromTile->tileIndexX;
+		int z = _fromTile->tileIndexZ;
+
+		int dx = std::abs(_toTile->tileIndexX - x);
+		int dz = std::abs(_toTile->tileIndexZ - z);
+		const int step_x = (_toTile->tileIndexX > x) ? 1 : -1;
+		const int step_z = (_toTile->tileIndexZ > z) ? 1 : -1;
+
+		// Supercover Line. Every step goes to the next Tile the line enters, along X or along Z. When it leaves through a corner, both ways.
+		int error = dx - dz;
+		dx *= 2;
+		dz *= 2;
+
+		while (x != _toTile->tileIndexX || z != _toTile->tileIndexZ)
+		{
+			if (error > 0)
+			{
+				x += step_x;
+				error -= dz;
+			}
+			else if (error < 0)
+			{
+				z += step_z;
+				error += dx;
+			}
+			else
+			{
+				if (!IsNodePassable(x + step_x, z) || !IsNodePassable(x, z + step_z))
+				{
+					return false;
+				}
+
+				x += step_x;
+				z += step_z;
+				error += dx - dz;
+			}
+
+			if (!IsNodePassable(x, z))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	std::vector<MapTile *> Terrain::SmoothPath(const MapTile * _startTile, const std::vector<MapTile *>& _path) const
+	{
+		std::vector<MapTile *> corners;
+
+		// Walk the Path from its first step. A Waypoint can go if the one after it is in sight from the last corner we kept.
+		const MapTile * anchor = _startTile;
+
+		for (auto i = int(_path.size()) - 1; i >= 0; i--)
+		{
+			if (i > 0 && HasLineOfSight(anchor, _path[i - 1]))
+			{
+				continue;
+			}
+
+			corners.push_back(_path[i]);
+			anchor = _path[i];
+		}
+
+		std::reverse(corners.begin(), corners.end());
+		return corners;
+	}
+
+	void Terrain::BuildPlannerLandmarks()
+	{
+		// The Planner's Heuristic leans on the Landmarks. Without them, its first Search is close to a Dijkstra over everything around.
+		if (navLandmarks.empty())
+		{
+			navLandmarkCount = std::max(navLandmarkCount, DEFAULT_LANDMARK_COUNT);
+			BuildLandmarks();
+		}
+	}
+
+	std::vector<MapTile *> Terrain::RunPlanner(IncrementalPathPlanner& _planner, int _startIndex, int _endIndex, bool _smoothed) const
+	{
+		if (_planner.GetGoalIndex() != _endIndex)
+		{
+			_planner.Reset(*this, _startIndex, _endIndex);
+		}
+		else
+		{
+			_planner.MoveStart(_startIndex);
+			_planner.UpdateObstacles();
+		}
+
+		if (!_planner.ComputePath())
+		{
+			return std::vector<MapTile *>();
+		}
+
+		return _smoothed ? _planner.GetCorners() : _planner.GetPath();
+	}
+
+	std::vector<MapTile *> Terrain::GetPathFromPlanner(IncrementalPathPlanner& _planner, glm::vec3 _startPosition, glm::vec3 _endPosition)
+	{
+		const int start_index = GetTileIndex(GetTileFromIndices(GetNodeIndicesFromPos(_startPosition.x, _startPosition.z)));
+		const int end_index = GetTileIndex(GetTileFromIndices(GetNodeIndicesFromPos(_endPosition.x, _endPosition.z)));
+
+		BuildPlannerLandmarks();
+
+		auto return_vector = RunPlanner(_planner, start_index, end_index);
+
+		for (auto i : return_vector)
+		{
+			HighlightNode(i->tileIndexX, i->tileIndexZ);
+		}
+
+		return return_vector;
+	}
+
+	HierarchicalPath Terrain::GetHierarchicalPath(glm::vec3 _startPosition, glm::vec3 _endPosition)
+	{
+		const auto start_indices = GetNodeIndicesFromPos(_startPosition.x, _startPosition.z);
+		const auto end_indices = GetNodeIndicesFromPos(_endPosition.x, _endPosition.z);
+
+		return navHierarchy.FindPath(GetTileFromIndices(start_indices), GetTileFromIndices(end_indices));
+	}
+
+	void Terrain::RefineHierarchicalPath(HierarchicalPath& _path, unsigned int _segmentCount)
+	{
+		navHierarchy.Refine(_path, _segmentCount);
+	}
+
 	MapTile* Terrain::GetTileFromIndices(glm::ivec2 _nodeIndices)
 	{
 		return this->GetTileFromIndices(_nodeIndices.x, _nodeIndices.y);
 	}
 
-	MapTile* Terrain::GetTileFromIndices(int _x, int _y)
+	MapTile* Terrain::GetTileFromIndices(int _x, int _y)
+	{
+
+		// In one Block, a Z past the end would be the next Row's first Tile.
+		if ( _x >= int(nodeCountX) || _x < 0)
+		{
+			_x = 0;
+		}
+
+		if ( _y >= int(nodeCountZ) || _y < 0)
+		{
+			_y = 0;
+		}
+
+		return &tiles[_x * nodeCountZ + _y];
+	}
+
+	void Terrain::InitPathFinding()
+	{
+
+		navObstacleVersion++;
+		navObstacleEpoch++;
+		navObstacleChanges.clear();
+
+		for (auto k = 0; k < 8; k++)
+		{
+			navDirectionIndexOffsets[k] = MapTile::navDirectionOffsets[k].x * int(nodeCountZ) + MapTile::navDirectionOffsets[k].y;
+		}
+
+		for (auto i = 0; i < nodeCountX; i++) {
+			for (auto j = 0; j < nodeCountZ; j++) {
+
+				const int tile_index = i * nodeCountZ + j;
+
+				// For each neighbour, add to the cost.
+				auto variance = 0.0f;
+				auto neighbour_count = 0;
+
+				for (const auto& offset : MapTile::navDirectionOffsets){
+
+					const int x = i + offset.x;
+					const int z = j + offset.y;
+
+					if (x < 0 || z < 0 || x >= int(nodeCountX) || z >= int(nodeCountZ)) {
+						continue;
+					}
+
+					const auto temp = nodeHeights[x * nodeCountZ + z];
+					variance += temp * temp;
+					neighbour_count++;
+
+				}
+
+				variance /= float(neighbour_count);
+
+				navCosts[tile_index] = (( variance > 0.9f ) ? (0.9f) : variance) + 0.1f;
+
+				// If it is set to be not navigable, the cost doesn't change that fact.
+				if (navCosts[tile_index] < UNPASSABLE_NAV_COST_LIMIT) {
+					navWalkableTiles.Set(tile_index);
+				}
+
+			}
+		}
+
+		// Jump Point Search can only jump through Tiles where every step around them costs the same.
+		navMinCost = float(INT_MAX);
+
+		for (auto i = 0; i < nodeCountX; i++) {
+			for (auto j = 0; j < nodeCountZ; j++) {
+
+				const int tile_index = i * nodeCountZ + j;
+				auto& tile = tiles[tile_index];
+
+				if (IsTileWalkable(tile_index)) {
+					navMinCost = std::min(navMinCost, navCosts[tile_index]);
+				}
+
+				UpdateNavDirections(i, j);
+
+				tile.navUniformCost = true;
+
+				for (auto k = 0; k < 8 && tile.navUniformCost; k++) {
+					if (tile.CanStep(k) && navCosts[GetNeighbourIndex(tile_index, k)] != navCosts[tile_index]) {
+						tile.navUniformCost = false;
+					}
+				}
+
+			}
+		}
+
+		// Update the Tilsets based on whether you can walk or not.
+		ComputeTileSets();
+
+		// The Landmarks of the last Map are for its Tiles and Costs. Anything that used them, the Planners too, gets new ones.
+		if (PE_HEURISTIC_LANDMARKS == navHeuristic || !navLandmarks.empty())
+		{
+			BuildLandmarks();
+		}
+
+		// Log all the tilesets.
+		std::vector<int> tile_sets = GetAllTileSets();
+
+		std::string log_temp = "Available tilesets left: ";
+		for ( auto it: tile_sets)
+		{
+			log_temp += " " + std::to_string(it) + ",";
+		}
+
+		LOGGER.AddToLog(log_temp, PE_LOG_INFO);
+
+		navHierarchy.Build(*this);
+
+	}
+
+	/**
+	 * \brief Find the Root of a Union Find Set, halving the Path on the way up.
+	 */
+	static int FindTileSetRoot(std::vector<int>& _parents, int _index)
+	{
+		while (_parents[_index] != _index)
+		{
+			_parents[_index] = _parents[_parents[_index]];
+			_index = _parents[_index];
+		}
+		return _index;
+	}
+
+	void Terrain::UpdateNavDirections(int _x, int _z)
+	{
+		auto& tile = tiles[_x * nodeCountZ + _z];
+		tile.navDirections = 0;
+
+		for (auto k = 0; k < 8; k++)
+		{
+			if (IsNodePassable(_x + MapTile::navDirectionOffsets[k].x, _z + MapTile::navDirectionOffsets[k].y))
+			{
+				tile.navDirections |= (1 << k);
+			}
+		}
+	}
+
+	void Terrain::ComputeTileSets()
+	{
+		const int tile_count = nodeCountX * nodeCountZ;
+
+		std::vector<int> parents(tile_count);
+		for (auto i = 0; i < tile_count; i++)
+		{
+			parents[i] = i;
+		}
+
+		// One pass over the Links. The Root is always the smallest Index in the Set, so the Ids come out in the order of their first Tile.
+		for (auto i = 0; i < tile_count; i++)
+		{
+			const MapTile * tile = GetTileFromIndex(i);
+			if (!IsTilePassable(i))
+			{
+				continue;
+			}
+
+			// Half the Directions are enough. Every Link is the opposite Direction of one of these, seen from the other Tile.
+			for (auto k = 4; k < 8; k++)
+			{
+				if (!tile->CanStep(k))
+				{
+					continue;
+				}
+
+				const int root_a = FindTileSetRoot(parents, i);
+				const int root_b = FindTileSetRoot(parents, GetNeighbourIndex(i, k));
+
+				if (root_a < root_b)
+				{
+					parents[root_b] = root_a;
+				}
+				else if (root_b < root_a)
+				{
+					parents[root_a] = root_b;
+				}
+			}
+		}
+
+		// Give every Root a dense Id, and count the Tiles and Bounds of its Set. Tiles you cannot step on are in no Set at all.
+		navTileSets.clear();
+		navFreeTileSets.clear();
+		navLiveTileSetCount = 0;
+
+		std::vector<int> root_ids(tile_count, -1);
+
+		for (auto i = 0; i < tile_count; i++)
+		{
+			MapTile * tile = GetTileFromIndex(i);
+
+			if (!IsTilePassable(i))
+			{
+				tile->navTileSet = -1;
+				continue;
+			}
+
+			const int root = FindTileSetRoot(parents, i);
+			if (root_ids[root] < 0)
+			{
+				root_ids[root] = CreateTileSet();
+			}
+
+			tile->navTileSet = root_ids[root];
+			AddToTileSet(tile->navTileSet, tile->tileIndexX, tile->tileIndexZ);
+		}
+	}
+
+	int Terrain::CreateTileSet()
+	{
+		navLiveTileSetCount++;
+
+		if (!navFreeTileSets.empty())
+		{
+			const int id = navFreeTileSets.back();
+			navFreeTileSets.pop_back();
+			navTileSets[id] = TileSetInfo();
+			return id;
+		}
+
+		navTileSets.emplace_back();
+		return int(navTileSets.size()) - 1;
+	}
+
+	void Terrain::AddToTileSet(int _tileSet, int _x, int _z)
 	{
+		auto& info = navTileSets[_tileSet];
 
-		if ( _x > nodeCountX || _x < 0)
+		if (0 == info.tileCount)
 		{
-			_x = 0;
+			info.bounds = glm::ivec4(_x, _z, _x, _z);
 		}
-
-		if ( _y > nodeCountZ || _y < 0)
+		else
 		{
-			_y = 0;
+			info.bounds = glm::ivec4(std::min(info.bounds.x, _x), std::min(info.bounds.y, _z), std::max(info.bounds.z, _x), std::max(info.bounds.w, _z));
 		}
 
-		return &tiles[_x][_y];
+		info.tileCount++;
 	}
 
-	void Terrain::InitPathFinding()
+	void Terrain::RemoveFromTileSet(int _tileSet, int _tileCount)
 	{
+		auto& info = navTileSets[_tileSet];
+		info.tileCount -= _tileCount;
 
-		for (auto i = 0; i < nodeCountX; i++) {
-			for (auto j = 0; j < nodeCountZ; j++) {
+		if (info.tileCount <= 0)
+		{
+			info.tileCount = 0;
+			navFreeTileSets.push_back(_tileSet);
+			navLiveTileSetCount--;
+		}
+	}
 
-				auto& tile = tiles[i][j];
+	void Terrain::SplitTileSet(MapTile& _obstacleTile)
+	{
+		const int old_tile_set = _obstacleTile.navTileSet;
+		_obstacleTile.navTileSet = -1;
 
-				FillNeighbours(tile);
+		if (old_tile_set < 0)
+		{
+			return;
+		}
 
-				// For each neighbour, add to the cost.
-				auto variance = 0.0f;
+		RemoveFromTileSet(old_tile_set, 1);
 
-				for (auto k = 0; k < tile.navNeighbourCount; k++){
+		// Every Neighbour that was in the same Set starts a Search. Any of them that cannot reach the others is now a Set of its own.
+		struct SplitSearch
+		{
+			std::deque<int> frontier;
+			std::vector<int> visited;
+			int mergedInto = -1;
+		};
 
-					const auto temp = tile.navNeighbours[k]->tilePosY;
-					variance += temp * temp;
+		std::vector<SplitSearch> searches;
+		std::unordered_map<int, int> owners;
 
-				}
+		auto find_search = [&](int _search)
+		{
+			while (searches[_search].mergedInto >= 0)
+			{
+				_search = searches[_search].mergedInto;
+			}
+			return _search;
+		};
 
-				variance /= float(tile.navNeighbourCount);
+		const int obstacle_index = GetTileIndex(&_obstacleTile);
 
-				tile.navCost = (( variance > 0.9f ) ? (0.9f) : variance) + 0.1f;
+		for (auto k = 0; k < 8; k++)
+		{
+			if (!_obstacleTile.CanStep(k))
+			{
+				continue;
+			}
 
-				// If it is set to be not navigable, the cost doesn't change that fact.
-				tile.navWalkable = (tile.navCost < UNPASSABLE_NAV_COST_LIMIT ) || tile.navWalkable;
-				tile.navTileSet = i * nodeCountZ + j;
+			const int index = GetNeighbourIndex(obstacle_index, k);
 
+			if (GetTileFromIndex(index)->navTileSet != old_tile_set)
+			{
+				continue;
+			}
+			if (owners.count(index))
+			{
+				continue;
 			}
+
+			owners[index] = int(searches.size());
+			searches.emplace_back();
+			searches.back().frontier.push_back(index);
+			searches.back().visited.push_back(index);
 		}
 
-		// Update the Tilsets based on whether you can walk or not.
-		bool changed = false;
-		do {
-			changed = false;
-
-			for (auto i = 0; i < nodeCountX; i++) {
-				for (auto j = 0; j < nodeCountZ; j++) {
-
-					auto&tile = tiles[i][j];
-					if (tile.navWalkable) {
-						for (auto k = 0; k < tile.navNeighbourCount; k++) {
-							const auto neighbour = tile.navNeighbours[k];
-							if (neighbour->navWalkable && neighbour->navTileSet < tile.navTileSet) {
-								changed = true;
-								tile.navTileSet = neighbour->navTileSet;
-							}
-						}
-					}
+		if (searches.size() < 2)
+		{
+			return;
+		}
+
+		// Grow all the Searches one Tile at a time. We can stop as soon as at most one of them is still growing.
+		// Everything else is then fully explored, so the work done is bounded by the size of the smaller pieces.
+		while (true)
+		{
+			int growing = 0;
 
+			for (auto s = 0; s < int(searches.size()); s++)
+			{
+				if (searches[s].mergedInto >= 0 || searches[s].frontier.empty())
+				{
+					continue;
 				}
-			}
-		} while (changed);
 
-		// Log all the tilesets.
-		std::vector<int> tile_sets = GetAllTileSets();
+				growing++;
 
-		std::string log_temp = "Available tilesets left: ";
-		for ( auto it: tile_sets)
-		{
-			log_temp += " " + std::to_string(it) + ",";
-		}
+				const int current_index = searches[s].frontier.front();
+				searches[s].frontier.pop_front();
+				const MapTile * current = GetTileFromIndex(current_index);
 
-		LOGGER.AddToLog(log_temp, PE_LOG_INFO);
+				for (auto k = 0; k < 8; k++)
+				{
+					if (!current->CanStep(k))
+					{
+						continue;
+					}
 
-	}
+					const int index = GetNeighbourIndex(current_index, k);
+					const auto owner = owners.find(index);
 
-	void Terrain::FillNeighbours(MapTile& _tile)
-	{
+					if (owner == owners.end())
+					{
+						owners[index] = s;
+						searches[s].frontier.push_back(index);
+						searches[s].visited.push_back(index);
+						continue;
+					}
 
-		// We Update the Tile Itself.
-		const auto& temp_x = _tile.tileIndexX;
-		const auto& temp_z = _tile.tileIndexZ;
+					// Two Searches met. They are in the same piece, so carry on as one.
+					const int other = find_search(owner->second);
+					if (other != s)
+					{
+						searches[other].mergedInto = s;
+						searches[s].frontier.insert(searches[s].frontier.end(), searches[other].frontier.begin(), searches[other].frontier.end());
+						searches[s].visited.insert(searches[s].visited.end(), searches[other].visited.begin(), searches[other].visited.end());
+						searches[other].frontier.clear();
+						searches[other].visited.clear();
+					}
+				}
+			}
 
-		/* TODO: Too many branches... Do something later on.*/
-		if (temp_z + 1 < nodeCountZ)
-		{
-			_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x][temp_z + 1];
-			_tile.navNeighbourCount++;
+			if (growing <= 1)
+			{
+				break;
+			}
 		}
 
-		if (temp_z - 1 > 0)
+		// The one still growing ( or the biggest, if none is ) keeps the old Set. The rest get new ones.
+		int keep = -1;
+		for (auto s = 0; s < int(searches.size()); s++)
 		{
-			_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x][temp_z - 1];
-			_tile.navNeighbourCount++;
+			if (searches[s].mergedInto < 0 && !searches[s].frontier.empty())
+			{
+				keep = s;
+			}
 		}
 
-		if (temp_x + 1 < nodeCountX)
+		if (keep < 0)
 		{
+			for (auto s = 0; s < int(searches.size()); s++)
+			{
+				if (searches[s].mergedInto < 0 && (keep < 0 || searches[s].visited.size() > searches[keep].visited.size()))
+				{
+					keep = s;
+				}
+			}
+		}
 
-			_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x + 1][temp_z];
-			_tile.navNeighbourCount++;
-
-			if (temp_z + 1 < nodeCountZ)
+		for (auto s = 0; s < int(searches.size()); s++)
+		{
+			if (s == keep || searches[s].mergedInto >= 0)
 			{
-				_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x + 1][temp_z + 1];
-				_tile.navNeighbourCount++;
+				continue;
 			}
 
-			if (temp_z - 1 > 0)
+			const int new_tile_set = CreateTileSet();
+			for (const auto index : searches[s].visited)
 			{
-				_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x + 1][temp_z - 1];
-				_tile.navNeighbourCount++;
+				MapTile * tile = GetTileFromIndex(index);
+				tile->navTileSet = new_tile_set;
+				AddToTileSet(new_tile_set, tile->tileIndexX, tile->tileIndexZ);
 			}
+
+			// The Bounds of the old Set are left as they are. They still hold everything in it, just not as tightly.
+			RemoveFromTileSet(old_tile_set, int(searches[s].visited.size()));
 		}
+	}
 
-		if (temp_x - 1 > 0)
+	bool Terrain::AreTilesConnected(const MapTile * _startTile, const MapTile * _endTile) const
+	{
+		if (_endTile->navTileSet < 0)
 		{
-			_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x - 1][temp_z];
-			_tile.navNeighbourCount++;
+			return false;
+		}
 
-			if (temp_z + 1 < nodeCountZ)
-			{
-				_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x - 1][temp_z + 1];
-				_tile.navNeighbourCount++;
-			}
+		if (_startTile->navTileSet == _endTile->navTileSet)
+		{
+			return true;
+		}
 
-			if (temp_z - 1 > 0)
+		// You can still walk off a Tile that had an Obstacle put on it.
+		const int start_index = GetTileIndex(_startTile);
+
+		for (auto k = 0; k < 8; k++)
+		{
+			if (_startTile->CanStep(k) && GetTileFromIndex(GetNeighbourIndex(start_index, k))->navTileSet == _endTile->navTileSet)
 			{
-				_tile.navNeighbours[_tile.navNeighbourCount] = &tiles[temp_x - 1][temp_z - 1];
-				_tile.navNeighbourCount++;
+				return true;
 			}
 		}
+
+		return false;
 	}
 
 	void Terrain::OnImguiRender()
@@ -627,20 +1978,17 @@ namespace pilot {
 
 	std::vector<int> Terrain::GetAllTileSets()
 	{
-		// Log all the tilesets.
 		std::vector<int> tile_sets;
-		for (auto i = 0; i < nodeCountX; i++) {
-			for (auto j = 0; j < nodeCountZ; j++) {
-
-				const auto& tile = tiles[i][j];
-
-				// If you cannot find it, add.
-				if (std::find(tile_sets.begin(), tile_sets.end(), tile.navTileSet) == tile_sets.end()) {
-					tile_sets.push_back(tile.navTileSet);
-				}
+		tile_sets.reserve(navLiveTileSetCount);
 
+		for (auto i = 0; i < int(navTileSets.size()); i++)
+		{
+			if (navTileSets[i].tileCount > 0)
+			{
+				tile_sets.push_back(i);
 			}
 		}
+
 		return tile_sets;
 	}
 
@@ -674,91 +2022,371 @@ namespace pilot {
 		_in.read((char*)&startxz, sizeof(startxz));
 		_in.read((char*)&endxz, sizeof(endxz));
 
-		// Init creates the new tiles. So, delete them before that.
-		DeleteTiles();
-
+		// Init creates the new tiles, in place of the old ones.
 		this->Init();
 
 	}
 
-	void Terrain::DeleteTiles() const
+	Terrain::~Terrain() = default;
+
+	void Terrain::ResetObstacles()
 	{
-		for (auto i = 0; i < nodeCountX; i++) {
-			delete[] tiles[i];
+		if (!navObstacleTiles.Any())
+		{
+			return;
+		}
+
+		std::vector<int> obstacle_tiles;
+		navObstacleTiles.ForEachSet([&obstacle_tiles](size_t _tileIndex) { obstacle_tiles.push_back(int(_tileIndex)); });
+
+		navObstacleTiles.ClearAll();
+
+		// Only the Tiles that were Obstacles, and the Neighbours stepping onto them, can step anywhere new.
+		for (const auto tile_index : obstacle_tiles)
+		{
+			const int x = tile_index / nodeCountZ;
+			const int z = tile_index % nodeCountZ;
+
+			UpdateNavDirections(x, z);
+
+			for (const auto& offset : MapTile::navDirectionOffsets)
+			{
+				if (x + offset.x >= 0 && z + offset.y >= 0 && x + offset.x < int(nodeCountX) && z + offset.y < int(nodeCountZ))
+				{
+					UpdateNavDirections(x + offset.x, z + offset.y);
+				}
+			}
 		}
 
-		delete[] tiles;
+		ComputeTileSets();
+
+		navObstacleVersion++;
+		navObstacleEpoch++;
+		navObstacleChanges.clear();
+		navHierarchy.OnAllTilesChanged();
+
+		// Only the Nodes that were Obstacles change Colour.
+		if (!tileStates.empty())
+		{
+			for (const auto tile_index : obstacle_tiles)
+			{
+				ResetNodeColour(tile_index / nodeCountZ, tile_index % nodeCountZ);
+			}
+		}
 	}
 
-	Terrain::~Terrain()
+	void Terrain::ResetOccupiedBy()
 	{
-		DeleteTiles();
+		occupiedTiles.ClearAll();
 	}
 
-	void Terrain::ResetObstacles()
+	/**
+	 * \brief Walk the Cells of a Grid that a 2D Ray crosses, in order, from _tStart to _tEnd. Amanatides and Woo.
+	 * \param _visit Called with ( Cell X, Cell Z, t entering it, t leaving it ). Stops the Walk when it returns true.
+	 * \return Whether a Visit stopped the Walk.
+	 *
+	 * The Cells are _cellSize wide, and only the ones from _minCell up to, but not including, _endCell are visited.
+	 */
+	template <typename Visit>
+	static bool WalkGridCells(const glm::vec2& _origin, const glm::vec2& _direction, float _tStart, float _tEnd, float _cellSize, glm::ivec2 _minCell, glm::ivec2 _endCell, Visit _visit)
 	{
-		for (int i = 0 ; i < nodeCountX; i++)
+		const glm::vec2 start = _origin + _direction * _tStart;
+
+		glm::ivec2 cell(
+			glm::clamp(int(std::floor(start.x / _cellSize)), _minCell.x, _endCell.x - 1),
+			glm::clamp(int(std::floor(start.y / _cellSize)), _minCell.y, _endCell.y - 1)
+		);
+
+		const glm::ivec2 step(_direction.x > 0 ? 1 : -1, _direction.y > 0 ? 1 : -1);
+
+		// The t at which the Ray crosses into the next Cell along each Axis, and how much t it takes to cross a whole Cell.
+		glm::vec2 t_max(FLT_MAX);
+		glm::vec2 t_delta(FLT_MAX);
+
+		for (auto axis = 0; axis < 2; axis++)
+		{
+			if (_direction[axis] != 0.0f)
+			{
+				t_max[axis] = ((cell[axis] + (step[axis] > 0 ? 1 : 0)) * _cellSize - _origin[axis]) / _direction[axis];
+				t_delta[axis] = _cellSize / std::abs(_direction[axis]);
+			}
+		}
+
+		float t = _tStart;
+
+		while (t <= _tEnd && cell.x >= _minCell.x && cell.y >= _minCell.y && cell.x < _endCell.x && cell.y < _endCell.y)
 		{
-			for (int j = 0; j < nodeCountZ; j++) {
-				tiles[i][j].navObstacle = false;
+			const float t_next = glm::min(glm::min(t_max.x, t_max.y), _tEnd);
+
+			if (_visit(cell.x, cell.y, t, t_next))
+			{
+				return true;
+			}
+
+			const int axis = (t_max.x < t_max.y) ? 0 : 1;
+
+			if (t_max[axis] >= _tEnd)
+			{
+				break;
 			}
+
+			cell[axis] += step[axis];
+			t = t_max[axis];
+			t_max[axis] += t_delta[axis];
 		}
+
+		return false;
 	}
 
-	void Terrain::ResetOccupiedBy()
+	/**
+	 * \brief Ray and Triangle Intersection. Moller and Trumbore.
+	 * \return The t at which the Ray hits the Triangle, or a negative value if it does not.
+	 */
+	static float IntersectTriangle(const glm::vec3& _origin, const glm::vec3& _direction, const glm::vec3& _a, const glm::vec3& _b, const glm::vec3& _c)
 	{
-		for (int i = 0; i < nodeCountX; i++)
+		const glm::vec3 edge_1 = _b - _a;
+		const glm::vec3 edge_2 = _c - _a;
+
+		const glm::vec3 p = glm::cross(_direction, edge_2);
+		const float determinant = glm::dot(edge_1, p);
+
+		if (std::abs(determinant) < 1e-12f)
 		{
-			for (int j = 0; j < nodeCountZ; j++) {
-				tiles[i][j].occupiedBy = 0;
-			}
+			return -1.0f;
+		}
+
+		const float inverse_determinant = 1.0f / determinant;
+		const glm::vec3 s = _origin - _a;
+
+		// A little slack, so that Rays through the Edges and Corners do not slip between the Triangles.
+		const float slack = 1e-5f;
+
+		const float u = glm::dot(s, p) * inverse_determinant;
+		if (u < -slack || u > 1.0f + slack)
+		{
+			return -1.0f;
+		}
+
+		const glm::vec3 q = glm::cross(s, edge_1);
+
+		const float v = glm::dot(_direction, q) * inverse_determinant;
+		if (v < -slack || u + v > 1.0f + slack)
+		{
+			return -1.0f;
 		}
+
+		return glm::dot(edge_2, q) * inverse_determinant;
 	}
 
-	void Terrain::GetMouseRayPoint(Ray _ray, float _granularity)
+	bool Terrain::RaycastTerrain(const glm::vec3& _origin, const glm::vec3& _direction, glm::vec3& _hitPoint) const
 	{
+		const int quads_x = int(nodeCountX) - 1;
+		const int quads_z = int(nodeCountZ) - 1;
 
-		// Note: This method assumes that the tile positions obtained are in the World Space. Which means that the Actual terrain itseld has to be at Origin.
+		if (quads_x < 1 || quads_z < 1 || 0 == heightTree.GetLevelCount())
+		{
+			return false;
+		}
 
-		// Lets get the Ray Origin and Direction.
-		glm::vec3 ray_origin = _ray.GetOrigin();
-		glm::vec3 ray_direction = _ray.GetDirection();
+		// Walk in Quads, where Vertex ( i, j ) is at ( i, j ). The t along the Ray stays the same.
+		const glm::vec2 origin((_origin.x - gridLength / 2) / gridLength, (_origin.z - gridBreadth / 2) / gridBreadth);
+		const glm::vec2 direction(_direction.x / gridLength, _direction.z / gridBreadth);
 
-		// Now, the Ray is a function, R = R0 + t. D Where R is any point on the Ray, R0 being the Origin, D being the Direction and t, a floating point value.
+		// Clip the Ray to the Box around the whole Terrain.
+		const glm::vec2& root_range = heightTree.GetRootRange();
+		const glm::vec3 box_min(0.0f, root_range.x, 0.0f);
+		const glm::vec3 box_max(float(quads_x), root_range.y, float(quads_z));
+		const glm::vec3 local_origin(origin.x, _origin.y, origin.y);
+		const glm::vec3 local_direction(direction.x, _direction.y, direction.y);
 
-		// We Check for each Terrain Tile, which gets the closest in terms of a constant t, w.r.t x, y, z, axes.
-		glm::ivec2 closest_node{};
-		float deviation = INT_MAX;
+		float t_start = 0.0f;
+		float t_end = FLT_MAX;
 
-		for (auto i = 0; i < nodeCountX; i++) {
-			for (auto j = 0; j < nodeCountZ; j++) {
+		for (auto axis = 0; axis < 3; axis++)
+		{
+			if (local_direction[axis] == 0.0f)
+			{
+				if (local_origin[axis] < box_min[axis] || local_origin[axis] > box_max[axis])
+				{
+					return false;
+				}
 
-				const auto& tile = tiles[i][j];
+				continue;
+			}
 
-				glm::vec3 temporary_t{};
+			float t_0 = (box_min[axis] - local_origin[axis]) / local_direction[axis];
+			float t_1 = (box_max[axis] - local_origin[axis]) / local_direction[axis];
 
-				temporary_t.y = (tile.GetPosition().y - ray_origin.y) / (ray_direction.y);
-				temporary_t.x = (tile.GetPosition().x - ray_origin.x) / (ray_direction.x);
-				temporary_t.z = (tile.GetPosition().z - ray_origin.z) / (ray_direction.z);
+			if (t_0 > t_1)
+			{
+				std::swap(t_0, t_1);
+			}
 
-				// If the T  is same, as it ideally should be, this temp_deviation would be zero, i.e, the lowest it can be.
-				float temp_deviation = glm::abs(temporary_t.x - temporary_t.y) + glm::abs(temporary_t.z - temporary_t.y);
+			t_start = glm::max(t_start, t_0);
+			t_end = glm::min(t_end, t_1);
+		}
 
-				if (temp_deviation == 0) {
-					closest_node = { i, j };
-					deviation = 0;
-					pointedNodeIndices = closest_node;
-					return;
+		if (t_start > t_end)
+		{
+			return false;
+		}
+
+		float hit_t = -1.0f;
+
+		const auto vertex_position = [this](int _x, int _z)
+		{
+			return glm::vec3(vertices[_x * nodeCountZ + _z].position);
+		};
+
+		const auto visit_quad = [&](int _x, int _z, float _tEnter, float _tExit)
+		{
+			// The same two Triangles BuildMeshData makes.
+			const float t_0 = IntersectTriangle(_origin, _direction, vertex_position(_x, _z), vertex_position(_x, _z + 1), vertex_position(_x + 1, _z));
+			const float t_1 = IntersectTriangle(_origin, _direction, vertex_position(_x + 1, _z), vertex_position(_x, _z + 1), vertex_position(_x + 1, _z + 1));
+
+			// Only the hits while the Ray is over this Quad count. A little slack, so we do not lose the ones right on its Edges.
+			const float slack = (_tExit - _tEnter) * 1e-3f + _tExit * 1e-5f;
+			const auto is_in_quad = [&](float _t)
+			{
+				return _t >= 0.0f && _t >= _tEnter - slack && _t <= _tExit + slack;
+			};
+
+			float t = -1.0f;
+
+			if (is_in_quad(t_0))
+			{
+				t = t_0;
+			}
+
+			if (is_in_quad(t_1) && (t < 0.0f || t_1 < t))
+			{
+				t = t_1;
+			}
+
+			if (t >= 0.0f)
+			{
+				hit_t = t;
+				return true;
+			}
+
+			return false;
+		};
+
+		const auto visit_patch = [&](int _patchX, int _patchZ, float _tEnter, float _tExit)
+		{
+			// Skip the Patches the Ray passes over, or under.
+			const glm::vec2& range = heightTree.GetRange(0, _patchX, _patchZ);
+			const float y_enter = _origin.y + _direction.y * _tEnter;
+			const float y_exit = _origin.y + _direction.y * _tExit;
+
+			if (glm::min(y_enter, y_exit) > range.y || glm::max(y_enter, y_exit) < range.x)
+			{
+				return false;
+			}
+
+			const glm::ivec2 min_quad(_patchX * TERRAIN_PATCH_QUADS, _patchZ * TERRAIN_PATCH_QUADS);
+			const glm::ivec2 end_quad(glm::min(min_quad.x + TERRAIN_PATCH_QUADS, quads_x), glm::min(min_quad.y + TERRAIN_PATCH_QUADS, quads_z));
+
+			return WalkGridCells(origin, direction, _tEnter, _tExit, 1.0f, min_quad, end_quad, visit_quad);
+		};
+
+		if (!WalkGridCells(origin, direction, t_start, t_end, float(TERRAIN_PATCH_QUADS), glm::ivec2(0), heightTree.GetNodeCount(0), visit_patch))
+		{
+			return false;
+		}
+
+		_hitPoint = _origin + _direction * hit_t;
+		return true;
+	}
+
+	void Terrain::GetNodesInFrustum(const glm::mat4& _viewProjection, std::vector<glm::ivec3>& _nodes) const
+	{
+		_nodes.clear();
+
+		// The six Planes, as ( Normal, Distance ), pointing in. From the Rows of the Matrix.
+		glm::vec4 planes[6];
+		for (auto axis = 0; axis < 3; axis++)
+		{
+			const glm::vec4 row(_viewProjection[0][axis], _viewProjection[1][axis], _viewProjection[2][axis], _viewProjection[3][axis]);
+			const glm::vec4 w_row(_viewProjection[0][3], _viewProjection[1][3], _viewProjection[2][3], _viewProjection[3][3]);
+
+			planes[2 * axis] = w_row + row;
+			planes[2 * axis + 1] = w_row - row;
+		}
+
+		heightTree.Visit([&](int _level, const glm::ivec2& _firstVertex, const glm::ivec2& _lastVertex, const glm::vec2& _range)
+		{
+			// The Vertices sit in the middle of the Tiles.
+			const glm::vec3 box_min(_firstVertex.x * gridLength + gridLength / 2, _range.x, _firstVertex.y * gridBreadth + gridBreadth / 2);
+			const glm::vec3 box_max(_lastVertex.x * gridLength + gridLength / 2, _range.y, _lastVertex.y * gridBreadth + gridBreadth / 2);
+
+			bool is_inside = true;
+
+			for (const auto& plane : planes)
+			{
+				const glm::vec3 normal(plane);
+
+				// The Corners of the Box furthest along the Normal, and furthest against it.
+				const glm::vec3 far_corner = glm::mix(box_min, box_max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+				const glm::vec3 near_corner = glm::mix(box_max, box_min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+
+				if (glm::dot(normal, far_corner) + plane.w < 0.0f)
+				{
+					return false;
 				}
 
-				if (temp_deviation < deviation) {
-					deviation = temp_deviation;
-					closest_node = { i, j };
+				if (glm::dot(normal, near_corner) + plane.w < 0.0f)
+				{
+					is_inside = false;
 				}
 			}
+
+			if (is_inside || 0 == _level)
+			{
+				_nodes.emplace_back(_firstVertex.x, _firstVertex.y, _level);
+				return false;
+			}
+
+			return true;
+		});
+	}
+
+	bool Terrain::GetHighestPointInRect(const glm::vec2& _min, const glm::vec2& _max, glm::vec3& _point) const
+	{
+		// The Vertices inside the Rectangle. They sit in the middle of the Tiles.
+		const glm::ivec2 first_vertex(
+			int(std::ceil((_min.x - gridLength / 2) / gridLength)),
+			int(std::ceil((_min.y - gridBreadth / 2) / gridBreadth))
+		);
+		const glm::ivec2 last_vertex(
+			int(std::floor((_max.x - gridLength / 2) / gridLength)),
+			int(std::floor((_max.y - gridBreadth / 2) / gridBreadth))
+		);
+
+		glm::ivec2 vertex;
+
+		if (nodeHeights.empty() || !heightTree.FindHighest(&nodeHeights[0], first_vertex, last_vertex, vertex))
+		{
+			return false;
+		}
+
+		_point = glm::vec3(vertex.x * gridLength + gridLength / 2, nodeHeights[vertex.x * nodeCountZ + vertex.y], vertex.y * gridBreadth + gridBreadth / 2);
+		return true;
+	}
+
+	void Terrain::GetMouseRayPoint(Ray _ray, float _granularity)
+	{
+
+		// Note: This method assumes that the tile positions obtained are in the World Space. Which means that the Actual terrain itseld has to be at Origin.
+		glm::vec3 hit_point;
+
+		if (!RaycastTerrain(_ray.GetOrigin(), _ray.GetDirection(), hit_point))
+		{
+			return;
 		}
 
-		pointedNodeIndices = closest_node;
+		// The Vertices are in the middle of the Tiles, so the nearest Node is the Tile the Point is in.
+		pointedNodeIndices = GetNodeIndicesFromPos(hit_point.x, hit_point.z);
 		this->HighlightNode(pointedNodeIndices.x, pointedNodeIndices.y);
 
 	}
@@ -766,8 +2394,46 @@ namespace pilot {
 	void Terrain::SetTerrainNodeObstacle(glm::ivec2 _nodeIndices)
 	{
 
-		tiles[_nodeIndices.x][_nodeIndices.y].navObstacle = true;
-		areVerticesDirty = true;
+		// Buildings near the edge ask for Nodes off the Terrain.
+		if (_nodeIndices.x < 0 || _nodeIndices.y < 0 || _nodeIndices.x >= int(nodeCountX) || _nodeIndices.y >= int(nodeCountZ))
+		{
+			return;
+		}
+
+		const int tile_index = _nodeIndices.x * nodeCountZ + _nodeIndices.y;
+
+		if (!navObstacleTiles.Test(tile_index))
+		{
+			const bool was_passable = IsTilePassable(tile_index);
+
+			navObstacleTiles.Set(tile_index);
+
+			if (was_passable)
+			{
+				// Nobody can step onto it anymore. The Neighbours see it in the opposite Direction.
+				for (auto k = 0; k < 8; k++)
+				{
+					const int x = _nodeIndices.x + MapTile::navDirectionOffsets[k].x;
+					const int z = _nodeIndices.y + MapTile::navDirectionOffsets[k].y;
+
+					if (x >= 0 && z >= 0 && x < int(nodeCountX) && z < int(nodeCountZ))
+					{
+						tiles[x * nodeCountZ + z].navDirections &= ~(1 << ((k + 4) & 7));
+					}
+				}
+
+				SplitTileSet(tiles[tile_index]);
+				navObstacleChanges.push_back(tile_index);
+			}
+
+			navObstacleVersion++;
+			navHierarchy.OnTileChanged(_nodeIndices.x, _nodeIndices.y);
+		}
+
+		if (!tileStates.empty())
+		{
+			ResetNodeColour(_nodeIndices.x, _nodeIndices.y);
+		}
 
 	}
 }
@@ -4,100 +4,155 @@
 #include "Object.h"
 
 #include <fstream>
+#include <functional>
+#include <cstddef>
+#include "PathFindingContext.h"
+#include "HeightQuadtree.h"
+#include "TileBitset.h"
+#include "FlowField.h"
+#include "HierarchicalPathFinder.h"
+#include "IncrementalPathPlanner.h"
 
 namespace pilot {
 	class Ray;
 
+	class Texture;
+
 	/**
 	 * \brief The Struct to represent the Vertex Data of the Terrain
+	 *
+	 * Only what never changes once the Terrain is created. The Colours of the Tiles are in the Tile State Texture.
 	 */
 	struct TerrainVertexData{
 
-		long header = 11110000;
+		long header = 11100000;
 
 		glm::vec4 position{};
 		glm::vec4 normal{};
-		glm::vec4 colour{};
 		glm::vec4 texCoord{};
 	};
 
 	/**
-	 * \brief This represents a Tile in the Terrain.
+	 * \brief A single Path Query, for the Batched Path Queries.
 	 */
-	class MapTile {
-
-	public:
-
-		int tileIndexX;
-		int tileIndexZ;
-
-		float tilePosX;
-		float tilePosZ;
-		float tilePosY;
-
-
-		/* Calculated Navigation Stuff */
-		float navCost = 0.0f;
+	struct PathRequest
+	{
+		glm::vec3 startPosition{};
+		glm::vec3 endPosition{};
 
 		/**
-		 * \brief Is the Tile walkable or does it have any static elements attached to it.
+		 * \brief If set, the Path comes from repairing this Planner's Search, as in Terrain::GetPathFromPlanner. Each Planner
+		 * can only be in one Request of a Batch.
 		 */
-		bool navWalkable = true;
+		IncrementalPathPlanner * planner = nullptr;
 
 		/**
-		 * \brief Is there a dynamic obstacle in the path.
+		 * \brief Only the corners of the Path, as Terrain::SmoothPath gives them. A Planner keeps its corners till its Path changes.
 		 */
-		bool navObstacle = false;
+		bool smoothed = false;
+	};
 
+	/**
+	 * \brief The Heuristics GetPathFromTiles can use.
+	 */
+	enum PathHeuristic
+	{
 		/**
-		 * \brief Pointers to the Neighbours of this Tile.
+		 * \brief Manhattan Distance in World Units. Fast, but it overestimates, so the Paths are not always the cheapest.
 		 */
-		MapTile * navNeighbours[8];
+		PE_HEURISTIC_MANHATTAN,
 
 		/**
-		 * \brief Number of Neighbours. Should be in between 3 and 8.
+		 * \brief Octile Distance times the least navCost. Diagonal steps cost the same as straight ones here, so that is the Chebyshev Distance.
+		 * It never overestimates, so the Paths are the cheapest. The default.
 		 */
-		int navNeighbourCount = 0;
+		PE_HEURISTIC_OCTILE,
 
 		/**
-		 * \brief Does this tile belong to the OpenSet.
+		 * \brief The Octile Heuristic, or the bound from the Landmark Distance Tables ( ALT ), whichever is larger.
 		 */
-		bool navOpen;
+		PE_HEURISTIC_LANDMARKS
+	};
 
+	/**
+	 * \brief What we know about a Tile Set, kept up to date as Obstacles split it.
+	 */
+	struct TileSetInfo
+	{
 		/**
-		 * \brief Does this tile belong in the Closed Set.
+		 * \brief Number of Tiles in the Set. 0 if the Id is not in use.
 		 */
-		bool navClosed;
+		int tileCount = 0;
 
 		/**
-		 * \brief Which Tile did you arrive at this tile, from?
+		 * \brief ( min x, min z, max x, max z ) Node Indices of the Set, inclusive. Never smaller than the Set, but it can be larger after a split.
 		 */
-		MapTile * navParent = nullptr;
+		glm::ivec4 bounds{};
+	};
+
+	/**
+	 * \brief This represents a Tile in the Terrain.
+	 *
+	 * The Height, the Nav Cost, and whether it is Walkable, has an Obstacle or is Occupied are kept by the Terrain, in dense Arrays by Tile Index.
+	 * See Terrain::GetNavCost, Terrain::IsTilePassable and Terrain::GetOccupant.
+	 */
+	class MapTile {
+
+	public:
+
+		int tileIndexX;
+		int tileIndexZ;
+
+		float tilePosX;
+		float tilePosZ;
+
+
+		/* Calculated Navigation Stuff */
 
-		float navFCost = 0;
-		float navGCost = 0;
+		/**
+		 * \brief True if every Walkable Neighbour has the same navCost as this Tile, and all of them are linked.
+		 *
+		 * Jump Point Search only jumps through such Tiles. Everywhere else it falls back to plain A* steps.
+		 */
+		bool navUniformCost = false;
 
 		/**
-		 * \brief A Pointer to the Entity occupying this tile.
-		 * 
-		 * Entities update this every frame, so that we can use them directly later on in the same frame.
+		 * \brief One bit per Direction in navDirectionOffsets. Set if the Neighbour that way is on the Terrain, and you can step onto it.
+		 *
+		 * The Neighbours themselves are never stored. Their Index is this Tile's Index plus the Terrain's offset for the Direction.
 		 */
-		Entity * occupiedBy = nullptr;
+		unsigned char navDirections = 0;
 
 		/**
 		 * \brief The TileSet that this Tile belongs to.
 		 * 
 		 * If two tiles belong to two different Tile Sets, there exists no path between them.
+		 * This is a dense Id into the Terrain's Tile Set Registry. -1 for Tiles you cannot step on ( not Walkable, or with an Obstacle ).
 		 */
 		int navTileSet;
 
+		/**
+		 * \brief The ( X, Z ) Node Offsets of the 8 Directions, going around counter clockwise. Opposite Directions are 4 apart.
+		 */
+		static const glm::ivec2 navDirectionOffsets[8];
+
 		MapTile() = default;
 
 		/**
-		 * \brief Converts the Tile Position to a Vec3 and returns it.
-		 * \return Position as a Vec3
+		 * \brief Can you step off this Tile in the Direction.
+		 * \param _direction An Index into navDirectionOffsets.
 		 */
-		glm::vec3 GetPosition() const;
+		bool CanStep(int _direction) const
+		{
+			return (navDirections >> _direction) & 1;
+		}
+
+		/**
+		 * \brief Is _tile one of the Neighbours of this Tile, and can you step from here to there.
+		 * \param _tile The Tile to look for.
+		 * \return True if _tile is a Neighbour, and it is Passable.
+		 */
+		bool HasNeighbour(const MapTile * _tile) const;
 	};
 
 	/**
@@ -112,7 +167,10 @@ namespace pilot {
 
 		unsigned int nodeCountX{}, nodeCountZ{};
 
-		MapTile ** tiles{};
+		/**
+		 * \brief All the Tiles, in one Block. A Row of nodeCountZ Tiles for each X, so a Tile's Index is X * nodeCountZ + Z.
+		 */
+		std::unique_ptr<MapTile[]> tiles;
 
 		/**
 		 * \brief The Filename, from which this terrain is based on.
@@ -125,20 +183,144 @@ namespace pilot {
 		std::vector<TerrainVertexData> vertices;
 
 		/**
-		 * \brief Flag to Check if we need to update the Buffer.
+		 * \brief RGBA for each Tile, in the same order as the Vertices. RGB is the Colour, and A is how much the Shader mixes it in.
+		 *
+		 * This is all that changes from frame to frame, so the Vertices are uploaded once and never touched again.
+		 */
+		std::vector<unsigned char> tileStates;
+
+		/**
+		 * \brief The Texture the Shader reads the Tile States from. A Row for each X, and a Texel for each Z.
+		 */
+		std::shared_ptr<Texture> tileStateTexture;
+
+		/**
+		 * \brief For each Row of the Tile States, whether it changed since the last Upload.
+		 */
+		std::vector<unsigned char> tileStateRowDirty;
+
+		/**
+		 * \brief The Rows of the Tile States that changed since the last Upload.
+		 */
+		std::vector<unsigned int> dirtyTileStateRows;
+
+		/**
+		 * \brief The Tiles Highlighted since the last ClearColours.
+		 */
+		std::vector<unsigned int> highlightedTiles;
+
+		/**
+		 * \brief Set the State of a Tile. Only marks its Row dirty if the State is different.
+		 * \param _x X Index of the Tile
+		 * \param _z Z Index of the Tile
+		 * \param _colour The Colour
+		 * \param _highlight How much the Shader mixes the Colour in.
+		 */
+		void SetTileState(unsigned int _x, unsigned int _z, const glm::vec3& _colour, float _highlight);
+
+		/**
+		 * \brief Set the Colour of the Node back to Green or Red, based on whether we can walk on it.
+		 */
+		void ResetNodeColour(unsigned int _x, unsigned int _z);
+
+		/**
+		 * \brief The Height of each Node, X-Major. The same as the Tiles have, packed together for the Height Queries.
+		 */
+		std::vector<float> nodeHeights;
+
+		/**
+		 * \brief The Cost of stepping off each Tile, by Tile Index.
+		 */
+		std::vector<float> navCosts;
+
+		/**
+		 * \brief The Tiles that are Walkable, i.e, do not have any static elements attached to them.
 		 */
-		bool areVerticesDirty = false;
+		TileBitset navWalkableTiles;
 
 		/**
-		 * \brief The Indices
+		 * \brief The Tiles with a dynamic Obstacle on them.
+		 */
+		TileBitset navObstacleTiles;
+
+		/**
+		 * \brief The Tiles an Entity is on. Entities set these every frame, so that we can use them directly later on in the same frame.
+		 */
+		TileBitset occupiedTiles;
+
+		/**
+		 * \brief The Entity on each Tile. Only read where occupiedTiles is set, so that resetting them only has to clear the Bits.
+		 */
+		std::vector<Entity *> tileOccupants;
+
+		/**
+		 * \brief The Indices. All the Triangles at first, and the ones the LOD picked once SelectLod is called.
 		 */
 		std::vector<unsigned int> indices;
 
+		/**
+		 * \brief The lowest and the highest Node Height over every square of the Terrain. A Node at Level L covers TERRAIN_PATCH_QUADS << L
+		 * Quads along each side. The LOD Quadtree is the same Tree.
+		 */
+		HeightQuadtree heightTree;
+
+		/**
+		 * \brief How far a Node has to be from the Cameras to be drawn as it is, instead of as its four Children. In sizes of the Node.
+		 */
+		float lodRange = 2.0f;
+
+		/**
+		 * \brief The Nodes SelectLod picked, as ( X, Z, Level ). X and Z are the Indices of the first Vertex in the Node.
+		 */
+		std::vector<glm::ivec3> lodSelection;
+
+		/**
+		 * \brief The Level of the picked Node over each TERRAIN_PATCH_QUADS by TERRAIN_PATCH_QUADS Patch. To find the Neighbours to stitch to.
+		 */
+		std::vector<unsigned char> lodPatchLevels;
+
+		/**
+		 * \brief Clear the LOD Selection, for a new Height Tree.
+		 */
+		void ResetLodSelection();
+
+		/**
+		 * \brief Pick the Node, or go down to its Children if a Camera is too close.
+		 */
+		void SelectLodNode(int _x, int _z, int _level, const std::vector<glm::vec3>& _cameraPositions);
+
+		/**
+		 * \brief Add the Triangles of a picked Node to the Indices, stitched to its coarser Neighbours.
+		 */
+		void AddLodNodeIndices(const glm::ivec3& _node);
+
 		/**
 		 * \brief Pointer of the Created Object/Mesh.
 		 */
 		std::shared_ptr<Object> objectPtr;
 
+		/**
+		 * \brief Gives the Heights, when the Terrain is not based on a Height Map File. See the Constructors.
+		 */
+		std::function<float(float, float)> heightFunction;
+
+		/**
+		 * \brief Create the Mesh in Init. Off for the Terrains that are only used for Path Finding, e.g, with no GL Context.
+		 */
+		bool uploadMesh = true;
+
+		/**
+		 * \brief Allocate the Tiles, and set their Positions and Heights from the Height Map File or the Height Function.
+		 *
+		 * The Height Map is sampled Bilinearly, and can be 8 or 16 bit. The Rows are spread over the Worker Pool.
+		 */
+		void CreateTiles();
+
+		/**
+		 * \brief Fill in the Vertices, Indices and Normals from the Tiles. Does not touch the GPU.
+		 */
+		void BuildMeshData();
+
 		/**
 		 * \brief This is a float that can be used to modify the amplitude of the Terrain.
 		 * 
@@ -147,12 +329,172 @@ namespace pilot {
 		float heightFactor = 1.0f;
 
 		/**
-		 * \brief Computes the Normal based on its surrounding Nodes.
-		 * \param _x Node Index X
-		 * \param _z Node Index Z
-		 * \return Normal at Index X, Z
+		 * \brief Computes the Normals of the Vertices in a Rectangle of Nodes, from the Slopes to their surrounding Nodes.
+		 * \param _min The first Node Indices ( X, Z ) in the Rectangle
+		 * \param _max The last Node Indices ( X, Z ) in the Rectangle
+		 *
+		 * The Rows are spread over the Worker Pool, and each one is done in a single branch free loop.
+		 */
+		void ComputeNormals(glm::ivec2 _min, glm::ivec2 _max);
+
+		/**
+		 * \brief Whether some Heights changed since the last Update. The Normals around them have to be computed again, and the Height
+		 * Tree has to be Refit over them.
+		 */
+		bool areHeightsDirty = false;
+
+		/**
+		 * \brief The Rectangle of Nodes whose Heights changed since the last Update.
+		 */
+		glm::ivec2 dirtyHeightsMin{};
+		glm::ivec2 dirtyHeightsMax{};
+
+		/**
+		 * \brief The Search State used by the Path Queries made from the Main Thread.
+		 */
+		PathFindingContext navContext;
+
+		/**
+		 * \brief One Search State for each Worker of the Worker Pool, used by the Batched Path Queries.
+		 */
+		std::vector<PathFindingContext> navWorkerContexts;
+
+		/**
+		 * \brief Incremented whenever the Obstacles on the Terrain change. Anything built from the Obstacles is stale if it has an older Version.
+		 */
+		unsigned int navObstacleVersion = 0;
+
+		/**
+		 * \brief The Indices of the Tiles that got an Obstacle, in order. Incremental Planners catch up from where they last read.
+		 */
+		std::vector<int> navObstacleChanges;
+
+		/**
+		 * \brief Incremented whenever the Obstacle Change Log is cleared, i.e, whenever Obstacles are removed.
+		 */
+		unsigned int navObstacleEpoch = 0;
+
+		/**
+		 * \brief The least navCost of any Walkable Tile.
+		 */
+		float navMinCost = 0.1f;
+
+		/**
+		 * \brief The Flow Fields handed out so far, so that the same Goal Region shares one Field.
+		 */
+		std::vector<std::shared_ptr<FlowField>> navFlowFields;
+
+		/**
+		 * \brief The Clusters and Abstract Graph, for the long Path Queries.
+		 */
+		HierarchicalPathFinder navHierarchy;
+
+		/**
+		 * \brief Use Jump Point Search through the Uniform Cost regions, in GetPathFromTiles.
+		 */
+		bool navJumpPointSearch = true;
+
+		PathHeuristic navHeuristic = PE_HEURISTIC_OCTILE;
+
+		unsigned int navLandmarkCount = 0;
+
+		/**
+		 * \brief The Landmark Tiles, for the ALT Heuristic.
+		 */
+		std::vector<int> navLandmarks;
+
+		/**
+		 * \brief Cost to get from each Tile to each Landmark, navLandmarkCount per Tile. INT_MAX if it cannot get there.
+		 *
+		 * Obstacles are left out, so that the Costs never go up when they are removed. Placing them can only make real Paths dearer, so the bound holds.
+		 */
+		std::vector<float> navLandmarkDistances;
+
+		/**
+		 * \brief Estimate of the Cost from one Tile to the other, for A*.
+		 */
+		float HCost(const MapTile * _pointA, const MapTile * _pointB) const;
+
+		/**
+		 * \brief Pick the Landmarks, each one as far as we can get from the ones before it, and fill their Distance Tables.
+		 */
+		void BuildLandmarks();
+
+		/**
+		 * \brief Build the default Landmarks for the Incremental Planners' Heuristic, if there are none yet.
+		 */
+		void BuildPlannerLandmarks();
+
+		/**
+		 * \brief Bring the Planner up to date with the Start, the End and the Obstacles, and get its Path. Writes only to the Planner.
+		 * \param _smoothed Get only the corners of the Path.
+		 */
+		std::vector<MapTile *> RunPlanner(IncrementalPathPlanner& _planner, int _startIndex, int _endIndex, bool _smoothed = false) const;
+
+		/**
+		 * \brief Can a unit step onto the Node at (x, z). False outside the Terrain.
+		 */
+		bool IsNodePassable(int _x, int _z) const;
+
+		/**
+		 * \brief Jump from a Tile in a Direction, through the Uniform Cost Tiles, until we find a Jump Point.
+		 * \param _fromIndex The Index of the Tile to jump from.
+		 * \param _direction The ( X, Z ) Direction to jump in. Each component is -1, 0 or 1.
+		 * \param _endIndex The Index of the Tile we are searching for. It is always a Jump Point.
+		 * \param _cost Set to the cost of going from _fromIndex to the Jump Point.
+		 * \return The Index of the Jump Point. -1 if we hit an Obstacle or the edge of the Terrain first.
+		 */
+		int JumpFrom(int _fromIndex, glm::ivec2 _direction, int _endIndex, float& _cost) const;
+
+		/**
+		 * \brief The Tile Set Registry, indexed by Tile Set Id.
+		 */
+		std::vector<TileSetInfo> navTileSets;
+
+		/**
+		 * \brief Ids in the Registry that are not in use, so that the Ids stay dense.
+		 */
+		std::vector<int> navFreeTileSets;
+
+		unsigned int navLiveTileSetCount = 0;
+
+		/**
+		 * \brief Get an unused Tile Set Id, with an empty entry in the Registry.
+		 */
+		int CreateTileSet();
+
+		/**
+		 * \brief Count the Tile at (x, z) in a Tile Set, and grow its Bounds to hold it.
+		 */
+		void AddToTileSet(int _tileSet, int _x, int _z);
+
+		/**
+		 * \brief Take _tileCount Tiles out of a Tile Set. The Id is freed once it is empty.
+		 */
+		void RemoveFromTileSet(int _tileSet, int _tileCount);
+
+		/**
+		 * \brief Index offset of the Neighbour in each of the MapTile's Directions.
+		 */
+		int navDirectionIndexOffsets[8]{};
+
+		/**
+		 * \brief Recompute which Directions you can step in, from the Tile.
+		 */
+		void UpdateNavDirections(int _x, int _z);
+
+		/**
+		 * \brief Label the connected Tile Sets of the whole Terrain, with a Union Find over the passable Tiles.
 		 */
-		glm::vec3 ComputeGridNormal(int _x,int _z);
+		void ComputeTileSets();
+
+		/**
+		 * \brief A Tile just got an Obstacle on it. Split its Tile Set, if that cut it into pieces.
+		 * \param _obstacleTile The Tile. It must already have its Obstacle set.
+		 *
+		 * Only the pieces that got cut off are relabelled, so this is cheap when a building goes up in the middle of open ground.
+		 */
+		void SplitTileSet(MapTile& _obstacleTile);
 
 		/* Testing stuff */
 		glm::vec2 startxz{};
@@ -207,9 +549,12 @@ namespace pilot {
 			return nodeCountZ;
 		}
 
-		MapTile** GetTiles() const
+		/**
+		 * \brief All the Tiles, by Tile Index. See GetTileIndex.
+		 */
+		MapTile * GetTiles() const
 		{
-			return tiles;
+			return tiles.get();
 		}
 
 		const std::string& GetHeightMapFile() const
@@ -232,6 +577,70 @@ namespace pilot {
 			return objectPtr;
 		}
 
+		unsigned int GetObstacleVersion() const
+		{
+			return navObstacleVersion;
+		}
+
+		const std::vector<int>& GetObstacleChanges() const
+		{
+			return navObstacleChanges;
+		}
+
+		unsigned int GetObstacleEpoch() const
+		{
+			return navObstacleEpoch;
+		}
+
+		float GetMinNavCost() const
+		{
+			return navMinCost;
+		}
+
+		/**
+		 * \brief A Cost that getting from one Tile to the other can never be less than. Tighter once there are Landmarks.
+		 *
+		 * Unlike HCost, it never overestimates, and it keeps the Triangle Inequality, so the Incremental Planners can use it.
+		 * \param _fromTileIndex The Index of the Tile to start from.
+		 * \param _toTileIndex The Index of the Tile to get to.
+		 */
+		float GetPathCostLowerBound(int _fromTileIndex, int _toTileIndex) const;
+
+		unsigned int GetLastPathExpansions() const
+		{
+			return navContext.GetLastExpansions();
+		}
+
+		bool GetJumpPointSearch() const
+		{
+			return navJumpPointSearch;
+		}
+
+		/**
+		 * \brief Turn Jump Point Search on or off. With it off, GetPathFromTiles expands every Tile like plain A*.
+		 */
+		void SetJumpPointSearch(bool _enabled)
+		{
+			navJumpPointSearch = _enabled;
+		}
+
+		PathHeuristic GetPathHeuristic() const
+		{
+			return navHeuristic;
+		}
+
+		/**
+		 * \brief Pick the Heuristic for GetPathFromTiles.
+		 * \param _heuristic The Heuristic.
+		 * \param _landmarkCount How many Landmarks to use, for PE_HEURISTIC_LANDMARKS. Each one costs a float per Tile, and a Search over the Terrain to build.
+		 */
+		void SetPathHeuristic(PathHeuristic _heuristic, unsigned int _landmarkCount = 8);
+
+		const std::vector<int>& GetLandmarks() const
+		{
+			return navLandmarks;
+		}
+
 		/**
 		 * \brief Create a Terrain based on the Height Map Image
 		 * \param _mapLength The Length of the Terrain in the World Coordinates
@@ -240,18 +649,41 @@ namespace pilot {
 		 * \param _gridBreadth Breadth of each Tile in the Terrain
 		 * \param _heightMapFile The File to base the Height Map on
 		 */
-		Terrain(int _mapLength, int _mapBreadth, float _gridLength, float _gridBreadth, std::string _heightMapFile);
+		Terrain(int _mapLength, int _mapBreadth, float _gridLength, float _gridBreadth, std::string _heightMapFile, bool _uploadMesh = true);
+
+		/**
+		 * \brief Create a Terrain with Heights from a Function, e.g, a generated one.
+		 * \param _mapLength The Length of the Terrain in the World Coordinates
+		 * \param _mapBreadth The Breadth of the Terrain in the world Co-ordinates
+		 * \param _gridLength Length of each Grid in the Terrain
+		 * \param _gridBreadth Breadth of each Tile in the Terrain
+		 * \param _heightFunction Takes the ( X, Z ) of a Node, each from 0 to 1 across the Terrain, and gives its Height from 0 to 1. Same as a Height Map, where Black is 1.
+		 *                        Called from several Threads at once.
+		 * \param _uploadMesh Create the Mesh too. That needs a GL Context. Without it, the Terrain can only be used for Path Finding.
+		 */
+		Terrain(int _mapLength, int _mapBreadth, float _gridLength, float _gridBreadth, std::function<float(float, float)> _heightFunction, bool _uploadMesh = true);
 
 		/**
 		 * \brief Initialize the Terrain
 		 * 
 		 * 1. Load the Image and parse it.
-		 * 2. Create Vertices based in the Lengths and breadths passed.
-		 * 3. Calculate Normals for each vertex.
-		 * 4. Create the Object and push it to the Asset Manager to Render.
+		 * 2. Build the Path Finding Data.
+		 * 3. Create Vertices based in the Lengths and breadths passed.
+		 * 4. Calculate Normals for each vertex.
+		 * 5. Create the Object and push it to the Asset Manager to Render, unless the Terrain was created without a Mesh.
 		 */
 		void Init();
 
+		/**
+		 * \brief Create the Object from the Vertices, and the Tile State Texture, and push them to the Asset Manager. Needs a GL Context.
+		 */
+		void UploadMesh();
+
+		bool IsMeshUploaded() const
+		{
+			return nullptr != objectPtr;
+		}
+
 		/**
 		 * \brief Render the Terrain.
 		 */
@@ -262,7 +694,8 @@ namespace pilot {
 		 * \param _delatTime Delta Time
 		 * \param _totalTime Total Time
 		 * 
-		 * Push to the Buffer, if the Vertices are dirty.
+		 * Recompute the Normals around the Heights that changed, and push those Vertices to the Buffer.
+		 * Push the Rows of the Tile States that changed to the Tile State Texture.
 		 */
 		void Update(float _delatTime, float _totalTime);
 
@@ -270,9 +703,18 @@ namespace pilot {
 		 * \brief Gets the Height at a position in this terrain. All values are in World Space.
 		 * \param _x X Position
 		 * \param _z Z Position
-		 * \return Y Position
+		 * \return Y Position, Bilinearly interpolated between the four Nodes around it.
+		 */
+		float GetHeightAtPos(const float& _x, const float& _z) const;
+
+		/**
+		 * \brief Gets the Heights at a lot of positions at once. Same as GetHeightAtPos for each, but four at a time with SSE.
+		 * \param _x X Positions
+		 * \param _z Z Positions
+		 * \param _heights Filled with the Y Positions
+		 * \param _count Number of Positions
 		 */
-		float GetHeightAtPos(const float& _x, const float& _z);
+		void GetHeightsAtPositions(const float * _x, const float * _z, float * _heights, size_t _count) const;
 
 		/**
 		 * \brief Gets the Height of a Node in this Terrain. All the values are in World Space.
@@ -313,19 +755,212 @@ namespace pilot {
 		void ClearColours();
 
 		/**
-		 * \brief Get the Path from _startTile to _endTile
+		 * \brief Move a Node up or down. The Normals around it are computed again, and uploaded, in the next Update.
+		 * \param _x Node Index X
+		 * \param _z Node Index Z
+		 * \param _height The new Height, in World Units.
+		 *
+		 * The Navigation Costs stay as they were.
+		 */
+		void SetNodeHeight(int _x, int _z, float _height);
+
+		/**
+		 * \brief Pick a coarser Level of Detail for the parts of the Terrain far from the Cameras, and update the Indices to draw.
+		 * \param _cameraPositions Every Camera the Terrain is drawn for, in one go. Each part of it is as detailed as the nearest Camera needs.
+		 *
+		 * Each Node of the Quadtree is drawn with TERRAIN_PATCH_QUADS by TERRAIN_PATCH_QUADS Quads, skipping Vertices the coarser it is.
+		 * The Edges next to coarser Nodes are snapped to the Vertices of those, so there are no cracks. The Vertices are not touched.
+		 * The Indices only go up again when the picked Nodes change.
+		 */
+		void SelectLod(const std::vector<glm::vec3>& _cameraPositions);
+
+		float GetLodRange() const
+		{
+			return lodRange;
+		}
+
+		void SetLodRange(float _lodRange)
+		{
+			lodRange = _lodRange;
+		}
+
+		const std::vector<glm::ivec3>& GetLodSelection() const
+		{
+			return lodSelection;
+		}
+
+		/**
+		 * \brief Number of Rows of the Tile States that will be uploaded in the next Update.
+		 */
+		size_t GetDirtyTileStateRowCount() const
+		{
+			return dirtyTileStateRows.size();
+		}
+
+		const std::vector<unsigned char>& GetTileStates() const
+		{
+			return tileStates;
+		}
+
+		/**
+		 * \brief Get the Path from _startTile to _endTile, and highlight it.
 		 * \param _startTile The Map Tile where you start
 		 * \param _endTile The Map Tile where you end
 		 * \return A Vector of Tile, the path to take.
+		 *
+		 * Uses the Terrain's own Search State. Only call this from the Main Thread.
 		 */
 		std::vector<MapTile *> GetPathFromTiles(MapTile * _startTile, MapTile * _endTile);
 
+		/**
+		 * \brief Is there any Path from _startTile to _endTile. Only compares Tile Sets, so it is O(1).
+		 *
+		 * If the Start Tile has an Obstacle on it, you can still walk off it, so its Neighbours' Tile Sets count too.
+		 */
+		bool AreTilesConnected(const MapTile * _startTile, const MapTile * _endTile) const;
+
+		/**
+		 * \brief Get the Path from _startTile to _endTile, using the Search State in _context.
+		 * \param _startTile The Map Tile where you start
+		 * \param _endTile The Map Tile where you end
+		 * \param _context The Search State to use. One per thread.
+		 * \return A Vector of Tile, the path to take. The first step is at the back.
+		 *
+		 * This does not modify the Terrain, so any number of threads can call this at the same time, each with its own Context,
+		 * as long as nobody changes the Tiles while they do.
+		 */
+		std::vector<MapTile *> GetPathFromTiles(const MapTile * _startTile, const MapTile * _endTile, PathFindingContext& _context) const;
+
+		/**
+		 * \brief Start a Path Query that can be carried on over several calls to ContinuePathSearch, e.g, over several frames.
+		 * \param _startTile The Start Tile
+		 * \param _endTile The End Tile
+		 * \param _context The Scratch State of the Query. It belongs to this Query till it is done.
+		 * \return False if we already know there is no Path, without searching.
+		 */
+		bool BeginPathSearch(const MapTile * _startTile, const MapTile * _endTile, PathFindingContext& _context) const;
+
+		/**
+		 * \brief Carry on a Path Query started with BeginPathSearch. No Obstacles should be placed in between, or the result may walk through them.
+		 * \param _context The Context the Query was started with.
+		 * \param _maxExpansions How many Nodes we can expand in this call.
+		 * \param _path Gets the Path, the first step at the back, once it is found.
+		 * \return Whether the Query is done, and if it found a Path.
+		 */
+		PathSearchStatus ContinuePathSearch(PathFindingContext& _context, unsigned int _maxExpansions, std::vector<MapTile *>& _path) const;
+
 		/**
 		 * \brief Get the Path from start position to the end position
 		 * \return A Vector of Tiles, the path to take.
 		 */
 		std::vector<MapTile *> GetPathFromPositions(glm::vec3, glm::vec3);
 
+		/**
+		 * \brief Get the Paths for a Batch of Requests, spread over the Worker Pool, and highlight them.
+		 * \param _requests The Start and End Positions of each Path.
+		 * \return The Paths, in the same order as the Requests. Each one is the same as GetPathFromPositions would return for it,
+		 * or GetPathFromPlanner, for the Requests with a Planner.
+		 *
+		 * Call this from the Main Thread. The Tiles must not change until it returns.
+		 */
+		std::vector<std::vector<MapTile *>> GetPathsFromPositions(const std::vector<PathRequest>& _requests);
+
+		/**
+		 * \brief Get a Flow Field towards the Goal Region, for a Group Move Order.
+		 * \param _goalNodes The Node Indices of the Goal Tiles.
+		 * \return The Flow Field. If one was already built for the same Goals and the Obstacles have not changed since, that one is shared.
+		 */
+		std::shared_ptr<FlowField> GetFlowField(const std::vector<glm::ivec2>& _goalNodes);
+
+		/**
+		 * \brief Get the Tile to step onto next from _position, following the Flow Field.
+		 * \param _flowField The Flow Field to follow. It is rebuilt first, if the Obstacles changed since it was built.
+		 * \param _position The Current Position.
+		 * \return The next Tile. nullptr if you are on a Goal Tile, or the Goal cannot be reached from here.
+		 */
+		MapTile * GetFlowFieldNextTile(FlowField& _flowField, glm::vec3 _position);
+
+		/**
+		 * \brief Can a unit walk in a straight line between the centres of the two Tiles. Every Tile the line passes through has to be Passable.
+		 *
+		 * Where the line passes exactly through a corner, both Tiles beside the corner have to be Passable, so that it never cuts past an Obstacle.
+		 * \param _fromTile The Tile to start from. It does not need to be Passable, you can always walk off the Tile you are on.
+		 * \param _toTile The Tile to get to.
+		 * \return True if nothing is in the way.
+		 */
+		bool HasLineOfSight(const MapTile * _fromTile, const MapTile * _toTile) const;
+
+		/**
+		 * \brief Remove the Waypoints of a Path that a unit can walk straight past, leaving only the corners.
+		 * \param _startTile The Tile the Path starts from.
+		 * \param _path A Path from GetPathFromTiles, the first step at the back.
+		 * \return The corners of the Path, and its last Tile, the first one at the back.
+		 */
+		std::vector<MapTile *> SmoothPath(const MapTile * _startTile, const std::vector<MapTile *>& _path) const;
+
+		/**
+		 * \brief Get the Path from the start position to the end position, repairing the Planner's last Search instead of starting over.
+		 * The first call builds the Landmarks, if there are none yet, for the Planners' Heuristic.
+		 * \param _planner The unit's own Planner. It starts over if the end position is not the one it was planning for.
+		 * \param _startPosition The Start Position
+		 * \param _endPosition The End Position
+		 * \return A Vector of Tiles, the path to take. The first step is at the back.
+		 */
+		std::vector<MapTile *> GetPathFromPlanner(IncrementalPathPlanner& _planner, glm::vec3 _startPosition, glm::vec3 _endPosition);
+
+		/**
+		 * \brief Get a Path over the Abstract Graph, with only its first Segment refined into Tiles.
+		 * \param _startPosition The Start Position
+		 * \param _endPosition The End Position
+		 * \return The Path. Use RefineHierarchicalPath for the Tiles of the next Segments, as you walk along it.
+		 *
+		 * Much cheaper than GetPathFromPositions for long Paths across the Terrain. Uses the Terrain's own Search State. Only call this from the Main Thread.
+		 */
+		HierarchicalPath GetHierarchicalPath(glm::vec3 _startPosition, glm::vec3 _endPosition);
+
+		/**
+		 * \brief Refine the next few Segments of a Path from GetHierarchicalPath.
+		 * \param _path The Path
+		 * \param _segmentCount The Number of Segments to refine.
+		 */
+		void RefineHierarchicalPath(HierarchicalPath& _path, unsigned int _segmentCount = 1);
+
+		const HierarchicalPathFinder& GetHierarchicalPathFinder() const
+		{
+			return navHierarchy;
+		}
+
+		/**
+		 * \brief Get the Index of the Tile in a Row Major ( X, then Z ) layout. Matches the Index of its Vertex.
+		 * \param _tile The Tile
+		 * \return The Index of the Tile
+		 */
+		int GetTileIndex(const MapTile * _tile) const
+		{
+			return int(_tile - tiles.get());
+		}
+
+		/**
+		 * \brief Get the Tile from its Index. See GetTileIndex.
+		 * \param _tileIndex The Index of the Tile
+		 * \return Pointer to the Tile
+		 */
+		MapTile * GetTileFromIndex(int _tileIndex) const
+		{
+			return &tiles[_tileIndex];
+		}
+
+		/**
+		 * \brief Get the Index of the Neighbour in a Direction. Only valid if the Tile can step that way, see MapTile::CanStep.
+		 * \param _tileIndex The Index of the Tile
+		 * \param _direction An Index into MapTile::navDirectionOffsets.
+		 * \return The Index of the Neighbour.
+		 */
+		int GetNeighbourIndex(int _tileIndex, int _direction) const
+		{
+			return _tileIndex + navDirectionIndexOffsets[_direction];
+		}
+
 		/**
 		 * \brief Get the Node at the Node Indices
 		 * \param _nodeIndices Node Indices Vec2
@@ -341,6 +976,77 @@ namespace pilot {
 		 */
 		MapTile * GetTileFromIndices(int _x, int _y);
 
+		/**
+		 * \brief The Position of the Tile's Vertex, in World Space.
+		 */
+		glm::vec3 GetTilePosition(const MapTile * _tile) const
+		{
+			return glm::vec3(_tile->tilePosX, nodeHeights[GetTileIndex(_tile)], _tile->tilePosZ);
+		}
+
+		/**
+		 * \brief The Cost of stepping off the Tile.
+		 * \param _tileIndex The Index of the Tile. See GetTileIndex.
+		 */
+		float GetNavCost(int _tileIndex) const
+		{
+			return navCosts[_tileIndex];
+		}
+
+		float GetNavCost(const MapTile * _tile) const
+		{
+			return navCosts[GetTileIndex(_tile)];
+		}
+
+		/**
+		 * \brief Is the Tile walkable, i.e, does it not have any static elements attached to it.
+		 */
+		bool IsTileWalkable(int _tileIndex) const
+		{
+			return navWalkableTiles.Test(_tileIndex);
+		}
+
+		/**
+		 * \brief Is there a dynamic Obstacle on the Tile.
+		 */
+		bool IsTileObstacle(int _tileIndex) const
+		{
+			return navObstacleTiles.Test(_tileIndex);
+		}
+
+		/**
+		 * \brief Can a unit step onto the Tile.
+		 * \return True if it is Walkable and has no Obstacle on it.
+		 */
+		bool IsTilePassable(int _tileIndex) const
+		{
+			return navWalkableTiles.Test(_tileIndex) && !navObstacleTiles.Test(_tileIndex);
+		}
+
+		bool IsTilePassable(const MapTile * _tile) const
+		{
+			return IsTilePassable(GetTileIndex(_tile));
+		}
+
+		/**
+		 * \brief The Entity on the Node. nullptr if there is none.
+		 */
+		Entity * GetOccupant(glm::ivec2 _nodeIndices) const
+		{
+			const int tile_index = _nodeIndices.x * nodeCountZ + _nodeIndices.y;
+			return occupiedTiles.Test(tile_index) ? tileOccupants[tile_index] : nullptr;
+		}
+
+		/**
+		 * \brief Put the Entity on the Node, till the next ResetOccupiedBy.
+		 */
+		void SetOccupant(glm::ivec2 _nodeIndices, Entity * _entity)
+		{
+			const int tile_index = _nodeIndices.x * nodeCountZ + _nodeIndices.y;
+			occupiedTiles.Set(tile_index, nullptr != _entity);
+			tileOccupants[tile_index] = _entity;
+		}
+
 		/**
 		 * \brief Initialize the necessary variables for Pathfinding.
 		 * 
@@ -350,12 +1056,6 @@ namespace pilot {
 		 */
 		void InitPathFinding();
 
-		/**
-		 * \brief Populate the neighbours list of the Tile.
-		 * \param _tile The Tile to perform this operation on.
-		 */
-		void FillNeighbours(MapTile& _tile);
-
 		void OnImguiRender();
 
 		int GetNodeSetFromPos(float _x, float _z);
@@ -366,6 +1066,23 @@ namespace pilot {
 		 */
 		std::vector<int> GetAllTileSets();
 
+		/**
+		 * \brief Number of Tile Sets in use.
+		 */
+		unsigned int GetTileSetCount() const
+		{
+			return navLiveTileSetCount;
+		}
+
+		/**
+		 * \brief Get the Size and Bounds of a Tile Set.
+		 * \param _tileSet The Tile Set Id, from MapTile::navTileSet or GetAllTileSets.
+		 */
+		const TileSetInfo& GetTileSetInfo(int _tileSet) const
+		{
+			return navTileSets[_tileSet];
+		}
+
 		/**
 		 * \brief Save this to the Output Stream.
 		 * \param _out Output Stream Reference
@@ -378,20 +1095,15 @@ namespace pilot {
 		 */
 		void LoadFromFile(std::ifstream& _in);
 
-		/**
-		 * \brief Delete the Tiles ( Tiles are allocated on the Heap. Destroy Them )
-		 */
-		void DeleteTiles() const;
-
 		~Terrain();
 
 		/**
-		 * \brief Resets the Obstacle during Path.
+		 * \brief Resets the Obstacle during Path. Only the Tiles that had an Obstacle, and the ones around them, are looked at.
 		 */
 		void ResetObstacles();
 
 		/**
-		 * \brief Reset all the tiles to, Occupied by none
+		 * \brief Reset all the tiles to, Occupied by none. Clears the Bits, a Word at a time.
 		 */
 		void ResetOccupiedBy();
 
@@ -399,14 +1111,52 @@ namespace pilot {
 		bool terrainDebug = false;
 
 		/**
-		 * \brief Get the Intersection Point for the Ray and the Terrain.
+		 * \brief Get the Intersection Point for the Ray and the Terrain, and point at the Node nearest to it.
 		 * \param _ray The Mouse Ray, based on the Current Mouse Position and the View Matrix.
-		 * \param _granularity The Granularity with which to search for the Intersection.
+		 * \param _granularity Not used anymore. The Intersection is exact.
 		 * 
-		 * This is used in pathfinding.
+		 * This is used in pathfinding. If the Ray misses the Terrain, the Pointed Node stays as it was.
 		 */
 		void GetMouseRayPoint(Ray _ray, float _granularity = 0.5f);
 
+		/**
+		 * \brief Find where a Ray first hits the Terrain.
+		 * \param _origin Where the Ray starts
+		 * \param _direction Which way it goes. Does not have to be normalized.
+		 * \param _hitPoint Where it hits, if it does.
+		 * \return Whether the Ray hits the Terrain.
+		 *
+		 * Walks the Leaves of the Height Tree the Ray crosses, and skips the ones it passes over. In the rest, it walks the Quads and tests their
+		 * two Triangles. The cost grows with how far the Ray goes over the Terrain, not with the size of the Terrain.
+		 */
+		bool RaycastTerrain(const glm::vec3& _origin, const glm::vec3& _direction, glm::vec3& _hitPoint) const;
+
+		/**
+		 * \brief Find the Nodes of the Height Tree that can be seen, using their Boxes.
+		 * \param _viewProjection The Projection Matrix times the View Matrix
+		 * \param _nodes Filled with the Nodes, as ( X, Z, Level ). X and Z are the Indices of the first Vertex in the Node.
+		 *
+		 * A Node that is all inside the Frustum is given as it is, without going down to its Children.
+		 */
+		void GetNodesInFrustum(const glm::mat4& _viewProjection, std::vector<glm::ivec3>& _nodes) const;
+
+		/**
+		 * \brief Find the highest Vertex in a Rectangle on the Terrain. Parts of the Terrain lower than the highest one found so far are skipped.
+		 * \param _min The lowest ( X, Z ) of the Rectangle, in World Space
+		 * \param _max The highest ( X, Z ) of the Rectangle, in World Space
+		 * \param _point The Position of the highest Vertex.
+		 * \return false if there are no Vertices in the Rectangle.
+		 */
+		bool GetHighestPointInRect(const glm::vec2& _min, const glm::vec2& _max, glm::vec3& _point) const;
+
+		/**
+		 * \brief The lowest and the highest Node Height over every square of the Terrain. Refit in Update, after the Heights change.
+		 */
+		const HeightQuadtree& GetHeightTree() const
+		{
+			return heightTree;
+		}
+
 
 		void SetTerrainNodeObstacle(glm::ivec2 _nodeIndices);
 
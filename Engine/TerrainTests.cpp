@@ -27,4 +27,759 @@
 //	EXPECT_FLOAT_EQ(0.0f, result.y);*/
 //	EXPECT_FLOAT_EQ(0, i);
 //
-//}
\ No newline at end of file
+//}
+
+#if DEBUG
+
+#include "AllTests.h"
+#include "Terrain.h"
+#include "PathScheduler.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+TEST_F(AllTests, TerrainBatchedPathsMatchSerialPaths)
+{
+	pilot::Terrain terrain(25, 25, 0.5, 0.5, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+
+	std::vector<pilot::PathRequest> requests;
+
+	for (auto i = 0; i < 64; i++)
+	{
+		pilot::PathRequest request;
+		request.startPosition = glm::vec3((i % 8) * 3.0f, 0.0f, (i / 8) * 3.0f);
+		request.endPosition = glm::vec3(24.0f - (i / 8) * 3.0f, 0.0f, 24.0f - (i % 8) * 3.0f);
+		requests.push_back(request);
+	}
+
+	const auto batched_paths = terrain.GetPathsFromPositions(requests);
+
+	ASSERT_EQ(requests.size(), batched_paths.size());
+
+	for (auto i = 0; i < requests.size(); i++)
+	{
+		EXPECT_EQ(terrain.GetPathFromPositions(requests[i].startPosition, requests[i].endPosition), batched_paths[i]);
+	}
+
+	// With a Planner, a Request gets the same Path as the Planner would on its own.
+	std::vector<pilot::IncrementalPathPlanner> planners(requests.size());
+	std::vector<pilot::IncrementalPathPlanner> serial_planners(requests.size());
+
+	for (auto i = 0; i < requests.size(); i++)
+	{
+		requests[i].planner = &planners[i];
+	}
+
+	const auto planner_paths = terrain.GetPathsFromPositions(requests);
+
+	ASSERT_EQ(requests.size(), planner_paths.size());
+
+	for (auto i = 0; i < requests.size(); i++)
+	{
+		EXPECT_EQ(terrain.GetPathFromPlanner(serial_planners[i], requests[i].startPosition, requests[i].endPosition), planner_paths[i]);
+	}
+}
+
+TEST_F(AllTests, TerrainObstacleWallSplitsTileSet)
+{
+	pilot::Terrain terrain(63, 63, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+
+	const pilot::MapTile * left_tile = terrain.GetTileFromIndices(10, 10);
+	const pilot::MapTile * right_tile = terrain.GetTileFromIndices(50, 10);
+
+	ASSERT_TRUE(terrain.AreTilesConnected(left_tile, right_tile));
+
+	// Leave a gap, and the Tile Set stays whole.
+	for (auto z = 0; z < 63; z++)
+	{
+		terrain.SetTerrainNodeObstacle(glm::ivec2(30, z));
+	}
+	EXPECT_TRUE(terrain.AreTilesConnected(left_tile, right_tile));
+
+	const unsigned int tile_set_count = terrain.GetTileSetCount();
+	const int whole_size = terrain.GetTileSetInfo(left_tile->navTileSet).tileCount;
+
+	// Close it, and it splits in two.
+	terrain.SetTerrainNodeObstacle(glm::ivec2(30, 63));
+	EXPECT_FALSE(terrain.AreTilesConnected(left_tile, right_tile));
+	EXPECT_EQ(-1, terrain.GetTileFromIndices(30, 63)->navTileSet);
+	EXPECT_EQ(tile_set_count + 1, terrain.GetTileSetCount());
+	EXPECT_EQ(whole_size - 1, terrain.GetTileSetInfo(left_tile->navTileSet).tileCount + terrain.GetTileSetInfo(right_tile->navTileSet).tileCount);
+	EXPECT_TRUE(terrain.GetPathFromTiles(terrain.GetTileFromIndices(10, 10), terrain.GetTileFromIndices(50, 10)).empty());
+
+	// A Unit standing on the Wall can still walk off either side.
+	const pilot::MapTile * wall_tile = terrain.GetTileFromIndices(30, 20);
+	EXPECT_TRUE(terrain.AreTilesConnected(wall_tile, left_tile));
+	EXPECT_TRUE(terrain.AreTilesConnected(wall_tile, right_tile));
+
+	terrain.ResetObstacles();
+	EXPECT_TRUE(terrain.AreTilesConnected(left_tile, right_tile));
+}
+
+TEST_F(AllTests, TerrainHierarchicalPathIsWalkable)
+{
+	pilot::Terrain terrain(63, 63, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+
+	const glm::vec3 start_position(1.0f, 0.0f, 1.0f);
+	const glm::vec3 end_position(60.0f, 0.0f, 58.0f);
+
+	// Wall off most of a column, so that the Path has to go around it. Placing it only rebuilds the Clusters it is in.
+	for (auto z = 0; z < 56; z++)
+	{
+		terrain.SetTerrainNodeObstacle(glm::ivec2(30, z));
+	}
+
+	auto path = terrain.GetHierarchicalPath(start_position, end_position);
+	ASSERT_FALSE(path.IsEmpty());
+
+	terrain.RefineHierarchicalPath(path, static_cast<unsigned int>(path.waypoints.size()));
+	ASSERT_TRUE(path.IsFullyRefined());
+	ASSERT_FALSE(path.tiles.empty());
+
+	const pilot::MapTile * current = terrain.GetTileFromIndices(terrain.GetNodeIndicesFromPos(start_position));
+	for (auto it = path.tiles.rbegin(); it != path.tiles.rend(); ++it)
+	{
+		EXPECT_TRUE(current->HasNeighbour(*it));
+		EXPECT_TRUE(terrain.IsTilePassable(*it));
+		current = *it;
+	}
+
+	EXPECT_EQ(terrain.GetTileFromIndices(terrain.GetNodeIndicesFromPos(end_position)), current);
+}
+
+TEST_F(AllTests, TerrainJumpPointPathsCostTheSameAsAStar)
+{
+	const float pi = 3.14159265f;
+
+	// The Cost of a Tile comes from the Heights around it, so flat Terraces and Blocks give Uniform Cost regions, each with its
+	// own Cost, and the Steps between them are where the Cost changes. The Hills have almost no Uniform Cost Tiles.
+	const std::vector<std::function<float(float, float)>> height_functions = {
+		[](float _x, float _z) { return std::floor(_x * 6.0f) / 6.0f + std::floor(_z * 4.0f) / 8.0f; },
+		[](float _x, float _z) { return std::fmod(std::floor(_x * 8.0f) * 7.0f + std::floor(_z * 8.0f) * 3.0f, 5.0f) * 0.2f; },
+		[pi](float _x, float _z) { return 0.5f + 0.5f * std::sin(_x * 4.0f * pi) * std::cos(_z * 3.0f * pi); }
+	};
+
+	for (auto map = 0; map < int(height_functions.size()); map++)
+	{
+		pilot::Terrain terrain(126, 126, 1, 1, height_functions[map]);
+		terrain.SetPathHeuristic(pilot::PE_HEURISTIC_OCTILE);
+
+		std::mt19937 generator(100 + map);
+		std::uniform_int_distribution<int> distribution(0, 126);
+
+		// A scattered Obstacle here and there, and a few Walls, so that there are Forced Neighbours and Jumps cut short.
+		for (auto i = 0; i < 127 * 127 / 20; i++)
+		{
+			terrain.SetTerrainNodeObstacle(glm::ivec2(distribution(generator), distribution(generator)));
+		}
+
+		for (auto wall = 0; wall < 6; wall++)
+		{
+			const int x = distribution(generator);
+			const int z = distribution(generator);
+
+			for (auto k = 0; k < 40; k++)
+			{
+				terrain.SetTerrainNodeObstacle(wall % 2 ? glm::ivec2(x, z + k - 20) : glm::ivec2(x + k - 20, z));
+			}
+		}
+
+		const auto path_cost = [&terrain](const pilot::MapTile * _start, const pilot::MapTile * _end, const std::vector<pilot::MapTile *>& _path)
+		{
+			const pilot::MapTile * current = _start;
+			float cost = 0.0f;
+
+			for (auto it = _path.rbegin(); it != _path.rend(); ++it)
+			{
+				EXPECT_TRUE(current->HasNeighbour(*it));
+				EXPECT_TRUE(terrain.IsTilePassable(*it));
+				cost += terrain.GetNavCost(current);
+				current = *it;
+			}
+
+			EXPECT_EQ(_end, current);
+			return cost;
+		};
+
+		unsigned int paths_found = 0;
+
+		for (auto i = 0; i < 100; i++)
+		{
+			pilot::MapTile * start = terrain.GetTileFromIndices(distribution(generator), distribution(generator));
+			pilot::MapTile * end = terrain.GetTileFromIndices(distribution(generator), distribution(generator));
+
+			if (start == end)
+			{
+				continue;
+			}
+
+			terrain.SetJumpPointSearch(false);
+			const auto a_star_path = terrain.GetPathFromTiles(start, end);
+
+			terrain.SetJumpPointSearch(true);
+			const auto jump_point_path = terrain.GetPathFromTiles(start, end);
+
+			ASSERT_EQ(a_star_path.empty(), jump_point_path.empty());
+
+			if (!a_star_path.empty())
+			{
+				EXPECT_NEAR(path_cost(start, end, a_star_path), path_cost(start, end, jump_point_path), 0.001f);
+				paths_found++;
+			}
+		}
+
+		// Most of the Queries have to find something, or the comparison does not say much.
+		EXPECT_GT(paths_found, 50u);
+	}
+}
+
+TEST_F(AllTests, TerrainIncrementalPlannerRepairsPath)
+{
+	pilot::Terrain terrain(63, 63, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+
+	const glm::vec3 start_position(5.0f, 0.0f, 30.0f);
+	const glm::vec3 end_position(58.0f, 0.0f, 30.0f);
+
+	pilot::IncrementalPathPlanner planner;
+	ASSERT_FALSE(terrain.GetPathFromPlanner(planner, start_position, end_position).empty());
+
+	// Wall off most of a column across the Path, like a few Buildings would.
+	for (auto z = 10; z < 56; z++)
+	{
+		terrain.SetTerrainNodeObstacle(glm::ivec2(30, z));
+	}
+
+	const auto path = terrain.GetPathFromPlanner(planner, start_position, end_position);
+	ASSERT_FALSE(path.empty());
+
+	const int start_index = terrain.GetTileIndex(terrain.GetTileFromIndices(terrain.GetNodeIndicesFromPos(start_position)));
+	const int end_index = terrain.GetTileIndex(terrain.GetTileFromIndices(terrain.GetNodeIndicesFromPos(end_position)));
+
+	pilot::IncrementalPathPlanner fresh_planner;
+	fresh_planner.Reset(terrain, start_index, end_index);
+	ASSERT_TRUE(fresh_planner.ComputePath());
+
+	// The Repair only touches what the Wall changed.
+	EXPECT_LT(planner.GetLastExpansions(), fresh_planner.GetLastExpansions());
+
+	const auto fresh_path = fresh_planner.GetPath();
+
+	auto path_cost = [&terrain, start_index, end_index](const std::vector<pilot::MapTile *>& _path)
+	{
+		const pilot::MapTile * current = terrain.GetTileFromIndex(start_index);
+		float cost = 0.0f;
+
+		for (auto it = _path.rbegin(); it != _path.rend(); ++it)
+		{
+			EXPECT_TRUE(current->HasNeighbour(*it));
+			EXPECT_TRUE(terrain.IsTilePassable(*it));
+			cost += terrain.GetNavCost(current);
+			current = *it;
+		}
+
+		EXPECT_EQ(end_index, terrain.GetTileIndex(current));
+		return cost;
+	};
+
+	EXPECT_NEAR(path_cost(fresh_path), path_cost(path), 0.001f);
+}
+
+TEST_F(AllTests, TerrainPlannerLandmarksFollowTheLoadedMap)
+{
+	// Save a bigger Terrain, to load over a small one that already has Landmarks for its Planners.
+	const std::string file_name = "TerrainPlannerLandmarks.terrain";
+	{
+		pilot::Terrain big_terrain(127, 127, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+		std::ofstream out(file_name, std::ios::binary);
+		big_terrain.SaveToFile(out);
+	}
+
+	pilot::Terrain terrain(31, 31, 1, 1, TEXTURE_FOLDER + std::string("heightmap-divided.jpg"), false);
+
+	pilot::IncrementalPathPlanner planner;
+	ASSERT_FALSE(terrain.GetPathFromPlanner(planner, glm::vec3(1.0f, 0.0f, 1.0f), glm::vec3(29.0f, 0.0f, 29.0f)).empty());
+	ASSERT_FALSE(terrain.GetLandmarks().empty());
+
+	{
+		std::ifstream in(file_name, std::ios::binary);
+		terrain.LoadFromFile(in);
+	}
+	std::remove(file_name.c_str());
+
+	ASSERT_EQ(128u, terrain.GetNodeCountX());
+
+	// Every Landmark is on the new Map, and the Planner finds a Path as cheap as A* does, far past the old Map.
+	for (const auto landmark : terrain.GetLandmarks())
+	{
+		EXPECT_LT(landmark, int(terrain.GetNodeCountX() * terrain.GetNodeCountZ()));
+	}
+
+	const glm::vec3 start_position(100.0f, 0.0f, 10.0f);
+	const glm::vec3 end_position(10.0f, 0.0f, 120.0f);
+
+	pilot::IncrementalPathPlanner new_planner;
+	const auto path = terrain.GetPathFromPlanner(new_planner, start_position, end_position);
+	ASSERT_FALSE(path.empty());
+
+	terrain.SetPathHeuristic(pilot::PE_HEURISTIC_OCTILE);
+	const auto a_star_path = terrain.GetPathFromPositions(start_position, end_position);
+	ASSERT_FALSE(a_star_path.empty());
+
+	const auto path_cost = [&terrain, start_position](const std::vector<pilot::MapTile *>& _path)
+	{
+		const pilot::MapTile * current = terrain.GetTileFromIndices(terrain.GetNodeIndicesFromPos(start_position));
+		float cost = 0.0f;
+
+		for (auto it = _path.rbegin(); it != _path.rend(); ++it)
+		{
+			cost += terrain.GetNavCost(current);
+			current = *it;
+		}
+
+		return cost;
+	};
+
+	EXPECT_NEAR(path_cost(a_star_path), path_cost(path), 0.001f);
+}
+
+TEST_F(AllTests, TerrainScheduledPathsMatchPathsAndKeepBudget)
+{
+	pilot::Terrain terrain(63, 63, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+	pilot::PathScheduler scheduler(2);
+
+	const unsigned int expansion_budget = 50;
+
+	std::vector<std::pair<pilot::MapTile *, pilot::MapTile *>> queries;
+	std::vector<std::shared_ptr<pilot::PathTicket>> tickets;
+
+	for (auto i = 0; i < 12; i++)
+	{
+		queries.emplace_back(terrain.GetTileFromIndices((i * 5) % 63, (i * 11) % 63), terrain.GetTileFromIndices((i * 17 + 40) % 63, (i * 7 + 20) % 63));
+		tickets.push_back(scheduler.Request(queries.back().first, queries.back().second, (i % 2) ? pilot::PE_PATH_PRIORITY_HIGH : pilot::PE_PATH_PRIORITY_LOW));
+	}
+
+	std::vector<int> done_frames(tickets.size(), -1);
+	int frame = 0;
+
+	while (scheduler.GetPendingCount() > 0 && frame < 10000)
+	{
+		scheduler.Update(terrain, expansion_budget);
+		EXPECT_LE(scheduler.GetLastExpansions(), expansion_budget);
+
+		frame++;
+
+		for (auto i = 0; i < int(tickets.size()); i++)
+		{
+			if (done_frames[i] < 0 && !tickets[i]->IsPending())
+			{
+				done_frames[i] = frame;
+			}
+		}
+	}
+
+	ASSERT_EQ(0u, scheduler.GetPendingCount());
+
+	pilot::PathFindingContext context;
+	int last_high_priority_frame = 0;
+	int first_low_priority_frame = frame;
+
+	for (auto i = 0; i < int(tickets.size()); i++)
+	{
+		EXPECT_EQ(terrain.GetPathFromTiles(queries[i].first, queries[i].second, context), tickets[i]->GetPath());
+
+		if (tickets[i]->GetPriority() == pilot::PE_PATH_PRIORITY_HIGH)
+		{
+			last_high_priority_frame = std::max(last_high_priority_frame, done_frames[i]);
+		}
+		else
+		{
+			first_low_priority_frame = std::min(first_low_priority_frame, done_frames[i]);
+		}
+	}
+
+	// A Low Priority Search only gets the budget left over in the frame the last High Priority one is done.
+	EXPECT_LE(last_high_priority_frame, first_low_priority_frame);
+}
+
+TEST_F(AllTests, TerrainNeighboursLinkBothWays)
+{
+	pilot::Terrain terrain(63, 63, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+
+	// Row and Column 0 used to be left out of the Neighbours of the Tiles next to them.
+	for (auto x = 0; x < 64; x++)
+	{
+		for (auto z = 0; z < 64; z++)
+		{
+			const pilot::MapTile * tile = terrain.GetTileFromIndices(x, z);
+
+			for (auto k = 0; k < 8; k++)
+			{
+				const int neighbour_x = x + pilot::MapTile::navDirectionOffsets[k].x;
+				const int neighbour_z = z + pilot::MapTile::navDirectionOffsets[k].y;
+				const bool on_terrain = neighbour_x >= 0 && neighbour_z >= 0 && neighbour_x < 64 && neighbour_z < 64;
+
+				EXPECT_EQ(on_terrain, tile->CanStep(k));
+
+				if (on_terrain)
+				{
+					EXPECT_TRUE(terrain.GetTileFromIndices(neighbour_x, neighbour_z)->CanStep((k + 4) % 8));
+				}
+			}
+		}
+	}
+
+	EXPECT_FALSE(terrain.GetPathFromTiles(terrain.GetTileFromIndices(10, 10), terrain.GetTileFromIndices(0, 0)).empty());
+
+	// Nobody can step onto an Obstacle, but you can still step off it.
+	terrain.SetTerrainNodeObstacle(glm::ivec2(0, 1));
+
+	EXPECT_FALSE(terrain.GetTileFromIndices(0, 0)->HasNeighbour(terrain.GetTileFromIndices(0, 1)));
+	EXPECT_FALSE(terrain.GetTileFromIndices(1, 1)->HasNeighbour(terrain.GetTileFromIndices(0, 1)));
+	EXPECT_TRUE(terrain.GetTileFromIndices(0, 1)->HasNeighbour(terrain.GetTileFromIndices(0, 0)));
+
+	terrain.ResetObstacles();
+
+	EXPECT_TRUE(terrain.GetTileFromIndices(0, 0)->HasNeighbour(terrain.GetTileFromIndices(0, 1)));
+}
+
+TEST_F(AllTests, TerrainSmoothedPathKeepsLineOfSight)
+{
+	pilot::Terrain terrain(63, 63, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+
+	// A Wall in the way, so that the Path has to turn around its end.
+	for (auto z = 0; z < 50; z++)
+	{
+		terrain.SetTerrainNodeObstacle(glm::ivec2(30, z));
+	}
+
+	const pilot::MapTile * start_tile = terrain.GetTileFromIndices(10, 10);
+	const pilot::MapTile * end_tile = terrain.GetTileFromIndices(50, 10);
+
+	EXPECT_FALSE(terrain.HasLineOfSight(start_tile, end_tile));
+	EXPECT_TRUE(terrain.HasLineOfSight(start_tile, terrain.GetTileFromIndices(29, 60)));
+
+	const auto path = terrain.GetPathFromTiles(terrain.GetTileFromIndices(10, 10), terrain.GetTileFromIndices(50, 10));
+	ASSERT_FALSE(path.empty());
+
+	const auto corners = terrain.SmoothPath(start_tile, path);
+
+	ASSERT_FALSE(corners.empty());
+	EXPECT_LT(corners.size(), path.size());
+	EXPECT_EQ(path.front(), corners.front());
+
+	const pilot::MapTile * current = start_tile;
+	for (auto it = corners.rbegin(); it != corners.rend(); ++it)
+	{
+		// The Path can squeeze past the corner of an Obstacle in a single Diagonal step. Those steps are kept as they are.
+		EXPECT_TRUE(terrain.HasLineOfSight(current, *it) || current->HasNeighbour(*it));
+		current = *it;
+	}
+}
+
+TEST_F(AllTests, TerrainPlannerKeepsCornersTillThePathChanges)
+{
+	pilot::Terrain terrain(63, 63, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"));
+
+	for (auto z = 0; z < 50; z++)
+	{
+		terrain.SetTerrainNodeObstacle(glm::ivec2(30, z));
+	}
+
+	const pilot::MapTile * end_tile = terrain.GetTileFromIndices(50, 10);
+	const glm::vec3 end_position = terrain.GetTilePosition(end_tile);
+
+	pilot::IncrementalPathPlanner planner;
+	std::vector<pilot::PathRequest> requests(1);
+	requests[0].startPosition = terrain.GetTilePosition(terrain.GetTileFromIndices(10, 10));
+	requests[0].endPosition = end_position;
+	requests[0].planner = &planner;
+	requests[0].smoothed = true;
+
+	const auto corners = terrain.GetPathsFromPositions(requests)[0];
+	const auto full_path = planner.GetPath();
+
+	ASSERT_FALSE(full_path.empty());
+	EXPECT_EQ(terrain.SmoothPath(terrain.GetTileFromIndices(10, 10), full_path), corners);
+
+	// Walking along the Path only drops the Tiles, and the corners, that are behind us.
+	requests[0].startPosition = terrain.GetTilePosition(full_path[full_path.size() - 3]);
+	const auto walked_corners = terrain.GetPathsFromPositions(requests)[0];
+
+	EXPECT_EQ(std::vector<pilot::MapTile *>(full_path.begin(), full_path.end() - 3), planner.GetPath());
+	EXPECT_EQ(std::vector<pilot::MapTile *>(corners.begin(), corners.begin() + walked_corners.size()), walked_corners);
+	EXPECT_EQ(0u, planner.GetLastExpansions());
+
+	// A new Obstacle on the Path builds it, and the corners, again.
+	const pilot::MapTile * blocked_tile = planner.GetPath()[planner.GetPath().size() / 2];
+	terrain.SetTerrainNodeObstacle(glm::ivec2(blocked_tile->tileIndexX, blocked_tile->tileIndexZ));
+
+	const auto repaired_corners = terrain.GetPathsFromPositions(requests)[0];
+	const auto repaired_path = planner.GetPath();
+
+	ASSERT_FALSE(repaired_path.empty());
+	EXPECT_EQ(repaired_path.end(), std::find(repaired_path.begin(), repaired_path.end(), blocked_tile));
+	EXPECT_EQ(terrain.SmoothPath(terrain.GetTileFromIndices(terrain.GetNodeIndicesFromPos(requests[0].startPosition)), repaired_path), repaired_corners);
+	EXPECT_EQ(end_tile, repaired_corners.front());
+}
+
+TEST_F(AllTests, TerrainUploadsOnlyChangedTileStates)
+{
+	pilot::Terrain terrain(255, 255, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+
+	EXPECT_EQ(0u, terrain.GetDirtyTileStateRowCount());
+
+	// Highlighting a couple of Nodes far apart dirties just their Rows.
+	terrain.HighlightNode(0, 0);
+	terrain.HighlightNode(200, 100);
+	EXPECT_EQ(255, terrain.GetTileStates()[(200 * terrain.GetNodeCountZ() + 100) * 4 + 3]);
+	EXPECT_EQ(2u, terrain.GetDirtyTileStateRowCount());
+
+	terrain.Update(0.0f, 0.0f);
+	EXPECT_EQ(0u, terrain.GetDirtyTileStateRowCount());
+
+	// Clearing them dirties the same Rows again. With nothing Highlighted, it does not dirty anything.
+	terrain.ClearColours();
+	EXPECT_EQ(2u, terrain.GetDirtyTileStateRowCount());
+
+	terrain.Update(0.0f, 0.0f);
+	terrain.ClearColours();
+	EXPECT_EQ(0u, terrain.GetDirtyTileStateRowCount());
+
+	terrain.SetTerrainNodeObstacle(glm::ivec2(100, 100));
+	EXPECT_EQ(1u, terrain.GetDirtyTileStateRowCount());
+
+	terrain.Update(0.0f, 0.0f);
+	terrain.ResetObstacles();
+	EXPECT_EQ(1u, terrain.GetDirtyTileStateRowCount());
+}
+
+TEST_F(AllTests, TerrainLodHasNoCracks)
+{
+	pilot::Terrain terrain(1023, 1023, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+
+	const size_t full_index_count = terrain.GetIndices().size();
+
+	terrain.SelectLod({ glm::vec3(100.0f, 20.0f, 300.0f), glm::vec3(900.0f, 20.0f, 900.0f) });
+
+	const auto& indices = terrain.GetIndices();
+	ASSERT_FALSE(indices.empty());
+	EXPECT_LT(indices.size() * 10, full_index_count);
+
+	// Without cracks, every Edge inside the Terrain is shared by exactly two Triangles. Only the ones on its Border are not.
+	std::map<std::pair<unsigned int, unsigned int>, int> edge_counts;
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		for (auto k = 0; k < 3; k++)
+		{
+			const unsigned int a = indices[i + k];
+			const unsigned int b = indices[i + (k + 1) % 3];
+			edge_counts[std::make_pair(glm::min(a, b), glm::max(a, b))]++;
+		}
+	}
+
+	const auto on_border = [&terrain](unsigned int _a, unsigned int _b)
+	{
+		const unsigned int a_x = _a / terrain.GetNodeCountZ(), a_z = _a % terrain.GetNodeCountZ();
+		const unsigned int b_x = _b / terrain.GetNodeCountZ(), b_z = _b % terrain.GetNodeCountZ();
+		const unsigned int last_x = terrain.GetNodeCountX() - 1, last_z = terrain.GetNodeCountZ() - 1;
+
+		return (a_x == b_x && (a_x == 0 || a_x == last_x)) || (a_z == b_z && (a_z == 0 || a_z == last_z));
+	};
+
+	for (const auto& edge : edge_counts)
+	{
+		EXPECT_EQ(on_border(edge.first.first, edge.first.second) ? 1 : 2, edge.second);
+	}
+
+	// Moving the Cameras far away leaves just a few coarse Nodes.
+	terrain.SelectLod({ glm::vec3(-10000.0f, 0.0f, -10000.0f) });
+	EXPECT_EQ(1u, terrain.GetLodSelection().size());
+}
+
+TEST_F(AllTests, TerrainNormalsFollowHeightEdits)
+{
+	pilot::Terrain terrain(31, 31, 1, 1, [](float, float) { return 0.0f; }, false);
+
+	const auto normal_at = [&terrain](unsigned int _x, unsigned int _z)
+	{
+		return glm::vec3(terrain.GetVertices()[_x * terrain.GetNodeCountZ() + _z].normal);
+	};
+
+	EXPECT_FLOAT_EQ(1.0f, normal_at(10, 10).y);
+
+	terrain.SetNodeHeight(10, 10, 2.0f);
+	terrain.Update(0.0f, 0.0f);
+
+	// The Nodes around the raised one lean away from it. The ones further out are still flat.
+	EXPECT_LT(normal_at(9, 10).x, 0.0f);
+	EXPECT_GT(normal_at(11, 10).x, 0.0f);
+	EXPECT_LT(normal_at(10, 9).z, 0.0f);
+	EXPECT_GT(normal_at(10, 11).z, 0.0f);
+	EXPECT_FLOAT_EQ(1.0f, normal_at(10, 10).y);
+	EXPECT_FLOAT_EQ(1.0f, normal_at(12, 10).y);
+}
+
+TEST_F(AllTests, TerrainRaycastHitsTheRightNode)
+{
+	pilot::Terrain terrain(127, 127, 1, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+
+	glm::vec3 hit_point;
+
+	// Straight down, and from far away at an angle, onto the Vertices of a few Nodes.
+	for (const auto& node : { glm::ivec2(20, 30), glm::ivec2(100, 5), glm::ivec2(64, 120) })
+	{
+		const glm::vec3 target = terrain.GetTilePosition(terrain.GetTileFromIndices(node.x, node.y));
+
+		for (const auto& offset : { glm::vec3(0.0f, 50.0f, 0.0f), glm::vec3(-80.0f, 40.0f, 60.0f), glm::vec3(30.0f, 5.0f, -200.0f) })
+		{
+			ASSERT_TRUE(terrain.RaycastTerrain(target + offset, -offset, hit_point));
+			EXPECT_EQ(node, terrain.GetNodeIndicesFromPos(hit_point.x, hit_point.z));
+			EXPECT_LT(glm::length(hit_point - target), 0.01f);
+		}
+	}
+
+	// Pointing away from the Terrain.
+	EXPECT_FALSE(terrain.RaycastTerrain(glm::vec3(64.0f, 50.0f, 64.0f), glm::vec3(0.0f, 1.0f, 0.0f), hit_point));
+	EXPECT_FALSE(terrain.RaycastTerrain(glm::vec3(-10.0f, 50.0f, -10.0f), glm::vec3(-1.0f, -1.0f, 0.0f), hit_point));
+}
+
+TEST_F(AllTests, TerrainSamplesHeightMapPixels)
+{
+	// The Pixels of heightmap-test-rgb.png, top Row first, as they are in the File.
+	const int pixels[3][3][3] = {
+		{ { 0, 30, 60 }, { 255, 255, 255 }, { 10, 20, 30 } },
+		{ { 90, 120, 150 }, { 200, 100, 0 }, { 60, 60, 60 } },
+		{ { 255, 0, 0 }, { 0, 0, 60 }, { 40, 80, 120 } }
+	};
+
+	// The Channels are averaged, and Black is the highest. The Image is flipped on load, so Node Z = 0 is the bottom Row.
+	const auto pixel_height = [&pixels](int _x, int _zFromBottom)
+	{
+		const int * pixel = pixels[2 - _zFromBottom][_x];
+		return 1.0f - (pixel[0] + pixel[1] + pixel[2]) / (3 * 255.0f);
+	};
+
+	// 5 by 5 Nodes over 3 by 3 Pixels. The even Nodes are on the Pixels, and the odd ones half way between them.
+	pilot::Terrain terrain(4, 4, 1, 1, TEXTURE_FOLDER + std::string("heightmap-test-rgb.png"), false);
+
+	ASSERT_EQ(5u, terrain.GetNodeCountX());
+	ASSERT_EQ(5u, terrain.GetNodeCountZ());
+
+	// Pure Red is a third of the way to White, not White.
+	EXPECT_FLOAT_EQ(2.0f / 3.0f, terrain.GetHeightForNode(0, 0));
+
+	// The Corner Nodes get exactly the Corner Pixels, and the middle Node the middle Pixel.
+	EXPECT_FLOAT_EQ(pixel_height(0, 0), terrain.GetHeightForNode(0, 0));
+	EXPECT_FLOAT_EQ(pixel_height(2, 0), terrain.GetHeightForNode(4, 0));
+	EXPECT_FLOAT_EQ(pixel_height(0, 2), terrain.GetHeightForNode(0, 4));
+	EXPECT_FLOAT_EQ(pixel_height(2, 2), terrain.GetHeightForNode(4, 4));
+	EXPECT_FLOAT_EQ(pixel_height(1, 1), terrain.GetHeightForNode(2, 2));
+
+	// Half way along an Edge, the average of two Pixels. In the middle of four, the average of all of them.
+	EXPECT_FLOAT_EQ((pixel_height(0, 0) + pixel_height(1, 0)) / 2, terrain.GetHeightForNode(1, 0));
+	EXPECT_FLOAT_EQ((pixel_height(1, 1) + pixel_height(1, 2)) / 2, terrain.GetHeightForNode(2, 3));
+	EXPECT_FLOAT_EQ((pixel_height(1, 0) + pixel_height(2, 0) + pixel_height(1, 1) + pixel_height(2, 1)) / 4, terrain.GetHeightForNode(3, 1));
+
+	// heightmap-test-16.png is 2 by 2, 16 bit Grey: 0 and 1 on the top Row, 12345 and 65535 on the bottom one.
+	pilot::Terrain terrain_16(1, 1, 1, 1, TEXTURE_FOLDER + std::string("heightmap-test-16.png"), false);
+
+	ASSERT_EQ(2u, terrain_16.GetNodeCountX());
+
+	EXPECT_FLOAT_EQ(1.0f - 12345.0f / 65535.0f, terrain_16.GetHeightForNode(0, 0));
+	EXPECT_FLOAT_EQ(0.0f, terrain_16.GetHeightForNode(1, 0));
+	EXPECT_FLOAT_EQ(1.0f, terrain_16.GetHeightForNode(0, 1));
+
+	// One step of 16 bits. Read as 8 bits, it would be lost.
+	EXPECT_FLOAT_EQ(1.0f - 1.0f / 65535.0f, terrain_16.GetHeightForNode(1, 1));
+	EXPECT_LT(terrain_16.GetHeightForNode(1, 1), terrain_16.GetHeightForNode(0, 1));
+}
+
+TEST_F(AllTests, TerrainHeightsAreInterpolated)
+{
+	pilot::Terrain terrain(254, 127, 2, 1, TEXTURE_FOLDER + std::string("heightmap.jpg"), false);
+
+	// On the Vertices we get the Node's Height, and half way between two we get the average.
+	EXPECT_FLOAT_EQ(terrain.GetHeightForNode(20, 30), terrain.GetHeightAtPos(41.0f, 30.5f));
+	EXPECT_FLOAT_EQ((terrain.GetHeightForNode(20, 30) + terrain.GetHeightForNode(21, 30)) / 2, terrain.GetHeightAtPos(42.0f, 30.5f));
+	EXPECT_FLOAT_EQ((terrain.GetHeightForNode(20, 30) + terrain.GetHeightForNode(20, 31)) / 2, terrain.GetHeightAtPos(41.0f, 31.0f));
+
+	// Off the Terrain, we get the Height at its Edge.
+	EXPECT_FLOAT_EQ(terrain.GetHeightForNode(0, 0), terrain.GetHeightAtPos(-10.0f, -10.0f));
+	EXPECT_FLOAT_EQ(terrain.GetHeightForNode(127, 127), terrain.GetHeightAtPos(1000.0f, 1000.0f));
+
+	// The Batch gives the same Heights, including the ones that are left over after the groups of four.
+	std::vector<float> xs, zs;
+	for (auto i = 0; i < 103; i++)
+	{
+		xs.push_back(-5.0f + i * 5.26f);
+		zs.push_back(130.0f - i * 1.37f);
+	}
+
+	std::vector<float> heights(xs.size());
+	terrain.GetHeightsAtPositions(xs.data(), zs.data(), heights.data(), heights.size());
+
+	for (auto i = 0; i < int(xs.size()); i++)
+	{
+		EXPECT_NEAR(terrain.GetHeightAtPos(xs[i], zs[i]), heights[i], 1e-4f);
+	}
+}
+
+TEST_F(AllTests, TerrainHeightTreeFollowsHeightEdits)
+{
+	pilot::Terrain terrain(100, 100, 1, 1, [](float _x, float _z) { return _x + _z; }, false);
+
+	const auto& height_tree = terrain.GetHeightTree();
+
+	EXPECT_FLOAT_EQ(terrain.GetHeightForNode(0, 0), height_tree.GetRootRange().x);
+	EXPECT_FLOAT_EQ(terrain.GetHeightForNode(100, 100), height_tree.GetRootRange().y);
+
+	glm::vec3 point;
+
+	// The Heights go up along X and Z, so the highest Vertex is in the far Corner of the Rectangle.
+	ASSERT_TRUE(terrain.GetHighestPointInRect(glm::vec2(10.0f, 20.0f), glm::vec2(40.0f, 30.0f), point));
+	EXPECT_EQ(glm::ivec2(39, 29), terrain.GetNodeIndicesFromPos(point.x, point.z));
+
+	// A Peak is found right away, and the Tree is back to the Terrain as it is, once it is gone.
+	terrain.SetNodeHeight(15, 25, 100.0f);
+
+	ASSERT_TRUE(terrain.GetHighestPointInRect(glm::vec2(10.0f, 20.0f), glm::vec2(40.0f, 30.0f), point));
+	EXPECT_EQ(glm::ivec2(15, 25), terrain.GetNodeIndicesFromPos(point.x, point.z));
+	EXPECT_FLOAT_EQ(100.0f, height_tree.GetRootRange().y);
+
+	terrain.SetNodeHeight(15, 25, 0.0f);
+	terrain.Update(0.0f, 0.0f);
+
+	EXPECT_FLOAT_EQ(terrain.GetHeightForNode(100, 100), height_tree.GetRootRange().y);
+	EXPECT_FALSE(terrain.GetHighestPointInRect(glm::vec2(200.0f, 200.0f), glm::vec2(300.0f, 300.0f), point));
+
+	// Looking down at the middle of the Terrain, the Nodes under the Camera are seen, and the far Corner is not.
+	const glm::mat4 view_projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f)
+		* glm::lookAt(glm::vec3(20.0f, 20.0f, 20.0f), glm::vec3(20.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	std::vector<glm::ivec3> nodes;
+	terrain.GetNodesInFrustum(view_projection, nodes);
+
+	const auto is_covered = [&](int _x, int _z)
+	{
+		for (const auto& node : nodes)
+		{
+			const int node_size = height_tree.GetNodeSize(node.z);
+
+			if (_x >= node.x && _x <= node.x + node_size && _z >= node.y && _z <= node.y + node_size)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	EXPECT_TRUE(is_covered(20, 20));
+	EXPECT_FALSE(is_covered(90, 90));
+}
+
+#endif
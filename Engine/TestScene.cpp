@@ -16,6 +16,9 @@
 
 #define		NAME_LENGTH_TO_FILE		20
 
+// How many Nodes the Path Scheduler can expand in a frame, over all the Searches.
+#define		PATH_EXPANSIONS_PER_FRAME	4096
+
 namespace pilot {
 
 	static void test_scene_resize(GLFWwindow * _window, int)
@@ -150,19 +153,35 @@ namespace pilot {
 			it.second->UpdateVectors();
 		}
 
-		// I can update all the Positions here.
+		// Find the Ground under everyone at once, and then update all the Positions here.
+		groundPositionsX.clear();
+		groundPositionsZ.clear();
+
+		for (const auto& it : entities) {
+			groundPositionsX.push_back(it->GetPosition().x);
+			groundPositionsZ.push_back(it->GetPosition().z);
+		}
+
+		for (const auto& it : animatedEntities) {
+			groundPositionsX.push_back(it->GetPosition().x);
+			groundPositionsZ.push_back(it->GetPosition().z);
+		}
+
+		groundHeights.resize(groundPositionsX.size());
+		testTerrain->GetHeightsAtPositions(groundPositionsX.data(), groundPositionsZ.data(), groundHeights.data(), groundHeights.size());
+
+		size_t ground_index = 0;
+
 		glm::vec3 temp_position{};
 		for (const auto& it : entities) {
 
 			temp_position = it->GetPosition();
-			temp_position.y = testTerrain->GetHeightAtPos(temp_position.x, temp_position.z);
+			temp_position.y = groundHeights[ground_index++];
 			it->SetPosition(temp_position);
 
 			it->Update(_deltaTime);
 			
-			testTerrain->GetTileFromIndices(
-				testTerrain->GetNodeIndicesFromPos(it->GetPosition())
-			)->occupiedBy = it.get();
+			testTerrain->SetOccupant(testTerrain->GetNodeIndicesFromPos(it->GetPosition()), it.get());
 		}
 
 		
@@ -172,7 +191,7 @@ namespace pilot {
 			auto it = animatedEntities[i];
 
 			temp_position = it->GetPosition();
-			temp_position.y = testTerrain->GetHeightAtPos(temp_position.x, temp_position.z);
+			temp_position.y = groundHeights[ground_index++];
 			it->SetPosition(temp_position);
 
 			// If You are actually attacking someone and they move, you are supposed to update the position.
@@ -180,7 +199,7 @@ namespace pilot {
 			it->Update(_deltaTime);
 			it->PlayAnimation(_deltaTime, _totalTime);
 
-			testTerrain->GetTileFromIndices(testTerrain->GetNodeIndicesFromPos(it->GetPosition()))->occupiedBy = it.get();
+			testTerrain->SetOccupant(testTerrain->GetNodeIndicesFromPos(it->GetPosition()), it.get());
 
 			// Now if you are supposed to attack, then attack every frame gradually. We should eventually change it to something like attack every 1 move or something like that.
 			// We have to make sure that no other person is attacking this target.
@@ -224,10 +243,17 @@ namespace pilot {
 
 		this->RayPicking();
 
-		/* Find Paths for each entity */
-		for (auto& it : animatedEntities)
+		/* Find Paths for each entity. Units on a Move bring their Planners up to date in one Batch, spread over the Worker Pool, so that a
+		 * new Order for a lot of units does not run all their first Searches one after the other. Searches for attacks go through the
+		 * Path Scheduler, so that they never take more than their share of the frame. */
+		std::vector<PathRequest> path_requests(animatedEntities.size());
+		std::vector<PathRequest> planner_requests;
+
+		for (auto i = 0; i < animatedEntities.size(); i++)
 		{
 
+			auto& it = animatedEntities[i];
+
 			// Make sure that the Target Node is up to date  if the Target moves around.
 			if( it->gPlay.attackingMode && it->gPlay.attackTarget != nullptr)
 			{
@@ -238,14 +264,122 @@ namespace pilot {
 				);
 			}
 
-			glm::vec3 startPosition = it->GetPosition();
 			glm::ivec2 end_node = it->GetTargetPosition();
 
-			glm::vec3 endPosition = testTerrain->GetTileFromIndices(end_node.x, end_node.y)->GetPosition();
+			path_requests[i].startPosition = it->GetPosition();
+			path_requests[i].endPosition = testTerrain->GetTilePosition(testTerrain->GetTileFromIndices(end_node.x, end_node.y));
 
 			testTerrain->HighlightNode(end_node.x, end_node.y);
 
-			path = testTerrain->GetPathFromPositions(startPosition, endPosition);
+			// Units on a Group Move follow the Flow Field till they reach the Formation. From there, they find their own way to their spot.
+			if (nullptr != it->GetFlowField())
+			{
+				const MapTile * current_tile = testTerrain->GetTileFromIndices(testTerrain->GetNodeIndicesFromPos(it->GetPosition()));
+
+				if (it->gPlay.attackingMode || it->GetFlowField()->IsGoal(testTerrain->GetTileIndex(current_tile)))
+				{
+					it->SetFlowField(nullptr);
+				}
+				else
+				{
+					// No need to search for this one.
+					path_requests[i].endPosition = path_requests[i].startPosition;
+				}
+			}
+
+			// The Target of an attack moves every frame, so there is nothing to keep. Units on a Move repair their last Search.
+			// A Planner holds a Node for every Tile, so units standing on their Target do not keep one.
+			const bool is_moving = !it->gPlay.attackingMode && nullptr == it->GetFlowField()
+				&& testTerrain->GetNodeIndicesFromPos(path_requests[i].startPosition) != end_node;
+
+			if (!is_moving)
+			{
+				it->SetPathPlanner(nullptr);
+			}
+			else
+			{
+				if (nullptr == it->GetPathPlanner())
+				{
+					it->SetPathPlanner(std::make_shared<IncrementalPathPlanner>());
+				}
+
+				// Only the corners. The Planner keeps them till its Path changes, so they are not smoothed again every frame.
+				planner_requests.push_back(path_requests[i]);
+				planner_requests.back().planner = it->GetPathPlanner().get();
+				planner_requests.back().smoothed = true;
+			}
+
+			if (it->gPlay.attackingMode)
+			{
+				if (nullptr == it->GetPathTicket())
+				{
+					it->SetPathTicket(std::make_shared<PathTicket>());
+				}
+
+				// Orders from the Player go first. Chasing a Target that moved can wait for a frame or two.
+				if (it->gPlay.newOrder || !it->GetPathTicket()->IsPending())
+				{
+					const glm::ivec2 start_node = testTerrain->GetNodeIndicesFromPos(path_requests[i].startPosition);
+
+					pathScheduler.Request(
+						it->GetPathTicket(),
+						testTerrain->GetTileFromIndices(start_node.x, start_node.y),
+						testTerrain->GetTileFromIndices(end_node.x, end_node.y),
+						it->gPlay.newOrder ? PE_PATH_PRIORITY_HIGH : PE_PATH_PRIORITY_LOW
+					);
+				}
+			}
+			else
+			{
+				// Nobody holding the Ticket anymore, the Scheduler drops the Request.
+				it->SetPathTicket(nullptr);
+			}
+
+			it->gPlay.newOrder = false;
+
+		}
+
+		pathScheduler.Update(*testTerrain, PATH_EXPANSIONS_PER_FRAME);
+
+		// In the same order as the units with a Planner.
+		const auto planner_paths = testTerrain->GetPathsFromPositions(planner_requests);
+		auto planner_path = planner_paths.begin();
+
+		for (auto i = 0; i < animatedEntities.size(); i++)
+		{
+
+			auto& it = animatedEntities[i];
+
+			glm::vec3 startPosition = path_requests[i].startPosition;
+			glm::vec3 endPosition = path_requests[i].endPosition;
+
+			path.clear();
+
+			if (nullptr != it->GetPathPlanner())
+			{
+				// Only the corners. Attacks count the Tiles left to the Target, so they keep every Tile.
+				path = *planner_path++;
+			}
+			else if (nullptr != it->GetPathTicket())
+			{
+				// The last Path found. A newer one may still be on its way.
+				path = it->GetPathTicket()->GetPath();
+
+				for (auto tile : path)
+				{
+					testTerrain->HighlightNode(tile->tileIndexX, tile->tileIndexZ);
+				}
+			}
+
+			if (nullptr != it->GetFlowField())
+			{
+				MapTile * next_tile = testTerrain->GetFlowFieldNextTile(*it->GetFlowField(), startPosition);
+
+				if (nullptr != next_tile)
+				{
+					path.push_back(next_tile);
+				}
+			}
 
 			std::string log_temp = "The path b/w the tiles, ";
 
@@ -317,7 +451,17 @@ namespace pilot {
 
 				// Traverse the Distance b/w them * deltaTime. --> You complete the distance two nodes in 1 second.
 				glm::vec3 current_position = it->GetPosition();
-				glm::vec3 final_position = current_position + ((next_tile->GetPosition() - current_position) * _deltaTime * it->gPlay.movementSpeed);
+				glm::vec3 step = (testTerrain->GetTilePosition(next_tile) - current_position) * _deltaTime * it->gPlay.movementSpeed;
+
+				// The next corner of a Smoothed Path can be many Tiles away. Do not go any faster than we would towards the next Tile.
+				const float max_step_length = testTerrain->GetGridLength() * _deltaTime * it->gPlay.movementSpeed;
+
+				if (glm::length(step) > max_step_length)
+				{
+					step = glm::normalize(step) * max_step_length;
+				}
+
+				glm::vec3 final_position = current_position + step;
 
 				// Get the Rotation, about, y ,axis, with both the nodes.
 				// Get the Vector, Target Node - Current Node.
@@ -418,6 +562,14 @@ namespace pilot {
 
 		cameraRay.Render(ASMGR.shaders.at("axes"), red);
 
+		// The Terrain is drawn for all the Viewports in one go, so it is as detailed as the nearest of their Cameras needs.
+		testTerrain->SelectLod({
+			viewportsDetails[0].camera->GetPosition(),
+			viewportsDetails[1].camera->GetPosition(),
+			viewportsDetails[2].camera->GetPosition(),
+			viewportsDetails[3].camera->GetPosition()
+		});
+
 		testTerrain->Render();
 
 	}
@@ -621,7 +773,7 @@ namespace pilot {
 			bool test_can_place = testTerrain->CanPlaceHere(target_node.x, target_node.y);
 
 			const MapTile * current_tile = testTerrain->GetTileFromIndices(target_node.x, target_node.y);
-			buildingPlacer->SetPosition(current_tile->GetPosition());
+			buildingPlacer->SetPosition(testTerrain->GetTilePosition(current_tile));
 
 			ASMGR.shaders.at("buildingPlacer")->use();
 			ASMGR.shaders.at("buildingPlacer")->setVec4("u_Colour0", glm::vec4((test_can_place) ? green : red, 1.0f));
@@ -640,7 +792,7 @@ namespace pilot {
 					Entity * last_entity = entities.back().get();
 					const float scaling_factor = 256.0f;
 					last_entity->SetScale(glm::vec3(1.0f / scaling_factor, 1.0f / scaling_factor, 1.0f / scaling_factor));
-					last_entity->SetPosition(testTerrain->GetTileFromIndices(target_node.x, target_node.y)->GetPosition());
+					last_entity->SetPosition(testTerrain->GetTilePosition(testTerrain->GetTileFromIndices(target_node.x, target_node.y)));
 
 					// We then update the corresponding terrain nodes to not walkable.
 
@@ -732,16 +884,19 @@ namespace pilot {
 			glm::ivec2 target_node = testTerrain->pointedNodeIndices;
 
 			// Check if the Target node already has an Entity. If so, we need to attack.
-			if ( testTerrain->GetTileFromIndices(target_node)->occupiedBy != nullptr/* && testTerrain->GetTileFromIndices(target_node)->occupiedBy->team != selectedEntities.back()->team*/)
+			const bool is_attack_order = testTerrain->GetOccupant(target_node) != nullptr/* && testTerrain->GetOccupant(target_node)->team != selectedEntities.back()->team*/;
+
+			if ( is_attack_order )
 			{
 				// Move to that tile, and attack.
 				// To Attack, we set them to be in attacking mode.
 				for ( auto it: selectedEntities)
 				{
 					it->gPlay.attackingMode = true;
+					it->gPlay.newOrder = true;
 					// You go there, and attack.
 
-					it->gPlay.attackTarget = testTerrain->GetTileFromIndices(target_node)->occupiedBy;
+					it->gPlay.attackTarget = testTerrain->GetOccupant(target_node);
 
 				}
 			}
@@ -768,6 +923,26 @@ namespace pilot {
 				}
 			}
 
+			// A Group Move builds one Flow Field to the whole Formation, instead of every unit searching on its own.
+			std::shared_ptr<FlowField> group_flow_field = nullptr;
+
+			if (!is_attack_order && number_of_selected_entities > 1)
+			{
+				std::vector<glm::ivec2> formation_nodes;
+
+				for (auto it : selectedEntities)
+				{
+					formation_nodes.push_back(it->GetTargetPosition());
+				}
+
+				group_flow_field = testTerrain->GetFlowField(formation_nodes);
+			}
+
+			for (auto it : selectedEntities)
+			{
+				it->SetFlowField(group_flow_field);
+			}
+
 		}
 
 	}
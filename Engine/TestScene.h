@@ -3,6 +3,7 @@
 #include "Scene.h"
 #include "Grid.h"
 #include "Terrain.h"
+#include "PathScheduler.h"
 
 namespace pilot {
 	
@@ -47,6 +48,18 @@ namespace pilot {
 
 		std::vector<MapTile*> path;
 
+		/**
+		 * \brief Runs the Path Searches for attacks, a frame's budget at a time.
+		 */
+		PathScheduler pathScheduler;
+
+		/**
+		 * \brief The X and Z Positions of all the Entities, and the Terrain Heights under them. Filled every frame, in one batch.
+		 */
+		std::vector<float> groundPositionsX;
+		std::vector<float> groundPositionsZ;
+		std::vector<float> groundHeights;
+
 		/* GUI Variables */
 		bool pathingDebugWindow = false;
 		bool displayAssetManagerWindow = false;
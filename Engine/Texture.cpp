@@ -51,4 +51,32 @@ namespace pilot
 
 	}
 
+	Texture::Texture(int _width, int _height, const unsigned char* _data)
+		: width(_width), height(_height)
+	{
+
+		glGenTextures(1, &textureId);
+		glBindTexture(GL_TEXTURE_2D, textureId);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, _data);
+		loaded = true;
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+	}
+
+	void Texture::UpdateRows(int _firstRow, int _rowCount, const unsigned char* _data)
+	{
+
+		glBindTexture(GL_TEXTURE_2D, textureId);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, _firstRow, width, _rowCount, GL_RGBA, GL_UNSIGNED_BYTE, _data);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+	}
+
 }
\ No newline at end of file
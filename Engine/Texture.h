@@ -12,6 +12,9 @@ namespace pilot
 		unsigned int textureId;
 		bool loaded = false;
 
+		int width = 0;
+		int height = 0;
+
 	public:
 		bool IsLoaded() const
 		{
@@ -35,6 +38,12 @@ namespace pilot
 
 		explicit Texture(const std::string& _imagePath, bool _flip_image = true);
 
+		// An RGBA Texture, filled from the CPU. It is not filtered, so that the Shaders can read each Texel as it is.
+		Texture(int _width, int _height, const unsigned char * _data);
+
+		// Replace some of the Rows of a Texture made from the CPU. _data points at the first Row to replace.
+		void UpdateRows(int _firstRow, int _rowCount, const unsigned char * _data);
+
 		~Texture() = default;
 	};
 	
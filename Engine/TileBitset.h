@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace pilot {
+
+	/**
+	 * \brief One Bit for each Tile, by Tile Index, packed 64 to a Word.
+	 *
+	 * Clearing or scanning the whole Terrain goes through the Words, so it reads 1/8th of a Byte per Tile.
+	 */
+	class TileBitset
+	{
+
+		std::vector<unsigned long long> words;
+
+		size_t bitCount = 0;
+
+		static int FirstSetBit(unsigned long long _word)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, _word);
+			return int(index);
+#else
+			return __builtin_ctzll(_word);
+#endif
+		}
+
+	public:
+
+		TileBitset() = default;
+
+		/**
+		 * \brief Resize to _count Bits, all set to _value.
+		 */
+		void Assign(size_t _count, bool _value)
+		{
+			bitCount = _count;
+			words.assign((_count + 63) / 64, _value ? ~0ull : 0ull);
+
+			// The Bits past the end stay clear, so that ForEachSet never gives them.
+			if (_value && (_count & 63))
+			{
+				words.back() = (1ull << (_count & 63)) - 1;
+			}
+		}
+
+		bool Test(size_t _index) const
+		{
+			return (words[_index >> 6] >> (_index & 63)) & 1;
+		}
+
+		void Set(size_t _index)
+		{
+			words[_index >> 6] |= 1ull << (_index & 63);
+		}
+
+		void Reset(size_t _index)
+		{
+			words[_index >> 6] &= ~(1ull << (_index & 63));
+		}
+
+		void Set(size_t _index, bool _value)
+		{
+			if (_value)
+			{
+				Set(_index);
+			}
+			else
+			{
+				Reset(_index);
+			}
+		}
+
+		/**
+		 * \brief Clear every Bit. A memset over the Words.
+		 */
+		void ClearAll()
+		{
+			std::fill(words.begin(), words.end(), 0ull);
+		}
+
+		bool Any() const
+		{
+			return std::any_of(words.begin(), words.end(), [](unsigned long long _word) { return 0 != _word; });
+		}
+
+		/**
+		 * \brief Call _function( Index ) for each set Bit, in order. Empty Words are skipped whole.
+		 */
+		template <typename Function>
+		void ForEachSet(Function _function) const
+		{
+			for (size_t w = 0; w < words.size(); w++)
+			{
+				for (unsigned long long word = words[w]; 0 != word; word &= word - 1)
+				{
+					_function(w * 64 + FirstSetBit(word));
+				}
+			}
+		}
+
+		size_t GetSize() const
+		{
+			return bitCount;
+		}
+
+		const std::vector<unsigned long long>& GetWords() const
+		{
+			return words;
+		}
+
+	};
+
+}
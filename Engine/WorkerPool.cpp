@@ -0,0 +1,111 @@
+#include "WorkerPool.h"
+
+namespace pilot {
+
+	WorkerPool::WorkerPool(unsigned int _threadCount)
+	{
+		if (0 == _threadCount)
+		{
+			const unsigned int hardware_threads = std::thread::hardware_concurrency();
+			_threadCount = (hardware_threads > 1) ? hardware_threads - 1 : 0;
+		}
+
+		// The calling thread is Worker 0. The Pool's threads start at 1.
+		for (unsigned int i = 0; i < _threadCount; i++)
+		{
+			threads.emplace_back(&WorkerPool::WorkerLoop, this, i + 1);
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			shuttingDown = true;
+		}
+
+		wakeCondition.notify_all();
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	void WorkerPool::RunJobs(unsigned int _workerIndex)
+	{
+		unsigned int index;
+		while ((index = nextJobIndex.fetch_add(1)) < jobCount)
+		{
+			(*job)(index, _workerIndex);
+		}
+	}
+
+	void WorkerPool::WorkerLoop(unsigned int _workerIndex)
+	{
+		unsigned int seen_generation = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeCondition.wait(lock, [&]() { return shuttingDown || seen_generation != jobGeneration; });
+
+				if (shuttingDown)
+				{
+					return;
+				}
+
+				seen_generation = jobGeneration;
+			}
+
+			RunJobs(_workerIndex);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				busyWorkers--;
+			}
+
+			doneCondition.notify_one();
+		}
+	}
+
+	void WorkerPool::ParallelFor(unsigned int _count, const std::function<void(unsigned int, unsigned int)>& _job)
+	{
+		if (0 == _count)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> dispatch_lock(dispatchMutex);
+
+		// Not worth waking everyone up for a single job.
+		if (threads.empty() || 1 == _count)
+		{
+			for (unsigned int i = 0; i < _count; i++)
+			{
+				_job(i, 0);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &_job;
+			jobCount = _count;
+			nextJobIndex = 0;
+			busyWorkers = static_cast<unsigned int>(threads.size());
+			jobGeneration++;
+		}
+
+		wakeCondition.notify_all();
+
+		RunJobs(0);
+
+		// Wait for the Workers to finish the jobs they took.
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCondition.wait(lock, [&]() { return 0 == busyWorkers; });
+		job = nullptr;
+	}
+
+}
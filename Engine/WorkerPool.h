@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+#define WORKERPOOL pilot::WorkerPool::GetInstance()
+
+namespace pilot {
+
+	/**
+	 * \brief A Pool of Worker Threads that stay alive for the whole run, so that we do not create threads every frame.
+	 *
+	 * Work is handed out as a Parallel For. The calling thread works on the jobs as well, and the call returns once all of them are done.
+	 */
+	class WorkerPool
+	{
+
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable wakeCondition;
+		std::condition_variable doneCondition;
+
+		/**
+		 * \brief Only one Parallel For can run at a time.
+		 */
+		std::mutex dispatchMutex;
+
+		const std::function<void(unsigned int, unsigned int)> * job = nullptr;
+		unsigned int jobCount = 0;
+		std::atomic<unsigned int> nextJobIndex{ 0 };
+
+		/**
+		 * \brief Incremented for every Parallel For, so that the Workers know there is new work.
+		 */
+		unsigned int jobGeneration = 0;
+
+		/**
+		 * \brief Number of Worker Threads still working on the current Parallel For.
+		 */
+		unsigned int busyWorkers = 0;
+
+		bool shuttingDown = false;
+
+		void WorkerLoop(unsigned int _workerIndex);
+
+		/**
+		 * \brief Keep taking job indices until there are none left.
+		 */
+		void RunJobs(unsigned int _workerIndex);
+
+	public:
+
+		/**
+		 * \brief Create the Pool.
+		 * \param _threadCount Number of Worker Threads. 0 uses one less than the number of hardware threads, as the caller works too.
+		 */
+		explicit WorkerPool(unsigned int _threadCount = 0);
+
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		static WorkerPool& GetInstance()
+		{
+			static WorkerPool instance;
+			return instance;
+		}
+
+		/**
+		 * \brief Number of threads that can run jobs, including the calling thread.
+		 */
+		unsigned int GetWorkerCount() const
+		{
+			return static_cast<unsigned int>(threads.size()) + 1;
+		}
+
+		/**
+		 * \brief Run _job for every index in [0, _count), spread over all the Workers. Blocks until every job is done.
+		 * \param _count Number of jobs.
+		 * \param _job Called with ( job index, worker index ). The worker index is less than GetWorkerCount(), and no two jobs run on the same worker index at the same time.
+		 */
+		void ParallelFor(unsigned int _count, const std::function<void(unsigned int, unsigned int)>& _job);
+
+	};
+
+}